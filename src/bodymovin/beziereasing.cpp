@@ -46,6 +46,15 @@ bool BezierEasing::isLinear() const {
 	return (mBezier.x2 == mBezier.y2) && (mBezier.x3 == mBezier.y3);
 }
 
+bool BezierEasing::same(const BezierEasing &other) const {
+	const auto &a = mBezier;
+	const auto &b = other.mBezier;
+	return (a.x1 == b.x1) && (a.y1 == b.y1)
+		&& (a.x2 == b.x2) && (a.y2 == b.y2)
+		&& (a.x3 == b.x3) && (a.y3 == b.y3)
+		&& (a.x4 == b.x4) && (a.y4 == b.y4);
+}
+
 qreal BezierEasing::valueForProgress(qreal progress) const {
 	return isLinear()
 		? progress
@@ -43,6 +43,9 @@ public:
 	bool isLinear() const;
 	qreal valueForProgress(qreal progress) const;
 
+	// Exact comparison of the control points.
+	bool same(const BezierEasing &other) const;
+
 private:
 	qreal tForX(qreal x) const;
 	QBezier mBezier;
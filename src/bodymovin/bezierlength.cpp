@@ -0,0 +1,129 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "bezierlength.h"
+
+#include <private/qbezier_p.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace Lottie {
+namespace {
+
+// Five point rule, exact for polynomials up to the ninth degree.
+constexpr auto kNodes = std::array<qreal, 5>{ {
+	0.,
+	-0.5384693101056830910,
+	0.5384693101056830910,
+	-0.9061798459386639928,
+	0.9061798459386639928,
+} };
+constexpr auto kWeights = std::array<qreal, 5>{ {
+	0.5688888888888888889,
+	0.4786286704993664680,
+	0.4786286704993664680,
+	0.2369268850561890875,
+	0.2369268850561890875,
+} };
+
+constexpr auto kMaxNewtonSteps = 8;
+constexpr auto kLengthPrecision = 1e-9;
+
+} // namespace
+
+BezierLength::BezierLength(const QBezier &bezier)
+: BezierLength(
+	bezier.x1, bezier.y1,
+	bezier.x2, bezier.y2,
+	bezier.x3, bezier.y3,
+	bezier.x4, bezier.y4) {
+}
+
+BezierLength::BezierLength(
+	qreal x1, qreal y1,
+	qreal x2, qreal y2,
+	qreal x3, qreal y3,
+	qreal x4, qreal y4)
+: _ax(3. * (x2 - x1))
+, _ay(3. * (y2 - y1))
+, _bx(3. * (x3 - x2))
+, _by(3. * (y3 - y2))
+, _cx(3. * (x4 - x3))
+, _cy(3. * (y4 - y3)) {
+	for (auto i = 0; i != kIntervals; ++i) {
+		_lengths[i + 1] = _lengths[i] + integrate(
+			qreal(i) / kIntervals,
+			qreal(i + 1) / kIntervals);
+	}
+}
+
+qreal BezierLength::length() const {
+	return _lengths.back();
+}
+
+qreal BezierLength::tAtLength(qreal length) const {
+	if (length <= 0.) {
+		return 0.;
+	} else if (length >= _lengths.back()) {
+		return 1.;
+	}
+	const auto interval = std::clamp(
+		int(std::upper_bound(begin(_lengths), end(_lengths), length)
+			- begin(_lengths)) - 1,
+		0,
+		kIntervals - 1);
+	const auto from = qreal(interval) / kIntervals;
+	const auto till = qreal(interval + 1) / kIntervals;
+	const auto start = _lengths[interval];
+	const auto full = _lengths[interval + 1] - start;
+	const auto wanted = length - start;
+
+	// The speed may vanish at cusps, then the step is bisected instead.
+	auto low = from;
+	auto high = till;
+	auto t = from + (till - from) * (wanted / full);
+	const auto precision = kLengthPrecision * std::max(_lengths.back(), 1.);
+	for (auto step = 0; step != kMaxNewtonSteps; ++step) {
+		const auto error = integrate(from, t) - wanted;
+		if (std::abs(error) <= precision) {
+			break;
+		} else if (error > 0.) {
+			high = t;
+		} else {
+			low = t;
+		}
+		const auto derivative = speed(t);
+		const auto next = (derivative > 0.)
+			? (t - error / derivative)
+			: (low + high) / 2.;
+		t = (next > low && next < high) ? next : (low + high) / 2.;
+	}
+	return t;
+}
+
+qreal BezierLength::speed(qreal t) const {
+	const auto u = 1. - t;
+	const auto a = u * u;
+	const auto b = 2. * u * t;
+	const auto c = t * t;
+	return std::hypot(
+		a * _ax + b * _bx + c * _cx,
+		a * _ay + b * _by + c * _cy);
+}
+
+qreal BezierLength::integrate(qreal from, qreal till) const {
+	const auto half = (till - from) / 2.;
+	const auto middle = (till + from) / 2.;
+	auto result = qreal(0.);
+	for (auto i = 0; i != int(kNodes.size()); ++i) {
+		result += kWeights[i] * speed(middle + half * kNodes[i]);
+	}
+	return result * half;
+}
+
+} // namespace Lottie
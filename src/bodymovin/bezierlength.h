@@ -0,0 +1,52 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include <QtGlobal>
+
+#include <array>
+
+class QBezier;
+
+namespace Lottie {
+
+// Arc length of a cubic bezier, integrated with the Gauss-Legendre
+// quadrature over a few parameter intervals kept in a table. The point
+// at a length is found with the Newton's method inside one interval.
+class BezierLength final {
+public:
+	explicit BezierLength(const QBezier &bezier);
+	BezierLength(
+		qreal x1, qreal y1,
+		qreal x2, qreal y2,
+		qreal x3, qreal y3,
+		qreal x4, qreal y4);
+
+	[[nodiscard]] qreal length() const;
+	[[nodiscard]] qreal tAtLength(qreal length) const;
+
+private:
+	static constexpr auto kIntervals = 16;
+
+	[[nodiscard]] qreal speed(qreal t) const;
+	[[nodiscard]] qreal integrate(qreal from, qreal till) const;
+
+	// The derivative is a(1-t)^2 + 2b(1-t)t + ct^2.
+	qreal _ax = 0.;
+	qreal _ay = 0.;
+	qreal _bx = 0.;
+	qreal _by = 0.;
+	qreal _cx = 0.;
+	qreal _cy = 0.;
+
+	// Lengths from the start till the end of each interval.
+	std::array<qreal, kIntervals + 1> _lengths = { { 0. } };
+
+};
+
+} // namespace Lottie
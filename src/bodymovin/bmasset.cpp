@@ -39,8 +39,7 @@ BMAsset::BMAsset(BMBase *parent) : BMBase(parent) {
 
 BMAsset::BMAsset(BMBase *parent, const BMAsset &other)
 : BMBase(parent, other)
-, m_id(other.m_id)
-, m_resolved(other.m_resolved) {
+, m_id(other.m_id) {
 }
 
 BMAsset *BMAsset::clone(BMBase *parent) const {
@@ -64,14 +63,6 @@ void BMAsset::parse(const JsonObject &definition) {
 	m_id = definition.value("id").toString();
 }
 
-void BMAsset::resolveAssets(
-		const std::function<BMAsset*(BMBase*, QByteArray)> &resolver) {
-	if (!m_resolved) {
-		m_resolved = true;
-		BMBase::resolveAssets(resolver);
-	}
-}
-
 QByteArray BMAsset::id() const {
 	return m_id;
 }
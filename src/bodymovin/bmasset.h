@@ -44,14 +44,10 @@ public:
 
 	void parse(const JsonObject &definition) override;
 
-	void resolveAssets(
-		const std::function<BMAsset*(BMBase*, QByteArray)> &resolver) override;
-
 	QByteArray id() const;
 
 private:
 	QByteArray m_id;
-	bool m_resolved = false;
 
 };
 
@@ -28,6 +28,7 @@
 ****************************************************************************/
 #include "bmbase.h"
 
+#include "complexity.h"
 #include "bmscene.h"
 #include "json.h"
 
@@ -91,16 +92,12 @@ void BMBase::render(Renderer &renderer, int frame) const {
 }
 
 void BMBase::resolveAssets(
+		int frame,
 		const std::function<BMAsset*(BMBase*, QByteArray)> &resolver) {
-	if (m_hidden) {
-		return;
-	}
-
 	for (BMBase *child : children()) {
-		if (child->m_hidden) {
-			continue;
+		if (child->active(frame)) {
+			child->resolveAssets(frame, resolver);
 		}
-		child->resolveAssets(resolver);
 	}
 }
 
@@ -133,4 +130,12 @@ bool BMBase::hidden() const {
 	return m_hidden;
 }
 
+void BMBase::analyze(Complexity &result) const {
+	for (BMBase *child : children()) {
+		if (!child->hidden()) {
+			child->analyze(result);
+		}
+	}
+}
+
 } // namespace Lottie
@@ -35,6 +35,7 @@ namespace Lottie {
 
 class BMAsset;
 class BMScene;
+struct Complexity;
 class Renderer;
 class JsonObject;
 
@@ -67,7 +68,12 @@ public:
 	virtual void updateProperties(int frame);
 	virtual void render(Renderer &renderer, int frame) const;
 
+	// Accumulates the counters of this element and its subtree.
+	virtual void analyze(Complexity &result) const;
+
+	// Resolves the assets referenced by the elements active at frame.
 	virtual void resolveAssets(
+		int frame,
 		const std::function<BMAsset*(BMBase*, QByteArray)> &resolver);
 
 protected:
@@ -29,6 +29,7 @@
 #include "bmbasictransform.h"
 
 #include "renderer.h"
+#include "complexity.h"
 
 namespace Lottie {
 
@@ -136,6 +137,10 @@ qreal BMBasicTransform::opacity() const {
 	return m_opacity.value() / 100.0;
 }
 
+bool BMBasicTransform::transparent() const {
+	return opacity() * 255. < 0.5;
+}
+
 QTransform BMBasicTransform::apply(QTransform to) const {
 	const auto pos = position();
 	const auto rot = rotation();
@@ -152,4 +157,14 @@ QTransform BMBasicTransform::apply(QTransform to) const {
 	return to;
 }
 
+void BMBasicTransform::analyze(Complexity &result) const {
+	m_anchorPoint.analyze(result);
+	m_position.analyze(result);
+	m_xPos.analyze(result);
+	m_yPos.analyze(result);
+	m_scale.analyze(result);
+	m_rotation.analyze(result);
+	m_opacity.analyze(result);
+}
+
 } // namespace Lottie
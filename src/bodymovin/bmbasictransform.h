@@ -45,6 +45,7 @@ public:
 
 	void updateProperties(int frame) override;
 	void render(Renderer &renderer, int frame) const override;
+	void analyze(Complexity &result) const override;
 	void renderWithoutOpacity(Renderer &renderer, int frame) const;
 
 	QPointF anchorPoint() const;
@@ -52,6 +53,8 @@ public:
 	QPointF scale() const;
 	qreal rotation() const;
 	qreal opacity() const;
+	// Nothing is drawn with an opacity that rounds to zero alpha.
+	bool transparent() const;
 
 	virtual QTransform apply(QTransform to) const;
 
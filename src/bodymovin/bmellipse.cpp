@@ -30,6 +30,7 @@
 
 #include "bmtrimpath.h"
 #include "renderer.h"
+#include "complexity.h"
 
 #include <QRectF>
 
@@ -103,4 +104,10 @@ QSizeF BMEllipse::size() const {
 	return m_size.value();
 }
 
+void BMEllipse::analyze(Complexity &result) const {
+	analyzeGeometry(result, 4);
+	m_position.analyze(result);
+	m_size.analyze(result);
+}
+
 } // namespace Lottie
@@ -45,6 +45,7 @@ public:
 
     void updateProperties(int frame) override;
     void render(Renderer &renderer, int frame) const override;
+    void analyze(Complexity &result) const override;
 
     bool acceptsTrim() const override;
 
@@ -29,6 +29,7 @@
 #include "bmfill.h"
 
 #include "renderer.h"
+#include "complexity.h"
 
 #include <QColor>
 
@@ -78,4 +79,10 @@ qreal BMFill::opacity() const {
 	return m_opacity.value();
 }
 
+void BMFill::analyze(Complexity &result) const {
+	++result.paints;
+	m_color.analyze(result);
+	m_opacity.analyze(result);
+}
+
 } // namespace Lottie
@@ -44,6 +44,7 @@ public:
 	void updateProperties(int frame) override;
 
 	void render(Renderer &renderer, int frame) const override;
+	void analyze(Complexity &result) const override;
 
 	QColor color() const;
 	qreal opacity() const;
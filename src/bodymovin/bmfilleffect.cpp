@@ -29,6 +29,7 @@
 #include "bmfilleffect.h"
 
 #include "renderer.h"
+#include "complexity.h"
 
 #include <QColor>
 
@@ -104,4 +105,10 @@ qreal BMFillEffect::opacity() const {
 	return m_opacity.value();
 }
 
+void BMFillEffect::analyze(Complexity &result) const {
+	++result.paints;
+	m_color.analyze(result);
+	m_opacity.analyze(result);
+}
+
 } // namespace Lottie
@@ -29,6 +29,7 @@
 #include "bmfreeformshape.h"
 
 #include "renderer.h"
+#include "complexity.h"
 
 namespace Lottie {
 
@@ -79,4 +80,10 @@ bool BMFreeFormShape::acceptsTrim() const {
 	return true;
 }
 
+void BMFreeFormShape::analyze(Complexity &result) const {
+	const auto animated = m_shape.vertexCount();
+	analyzeGeometry(result, animated ? animated : PathVertices(m_path));
+	m_shape.analyze(result);
+}
+
 } // namespace Lottie
@@ -29,11 +29,15 @@
 #include "bmgfill.h"
 
 #include "renderer.h"
+#include "complexity.h"
 
 #include <QLinearGradient>
 #include <QRadialGradient>
 #include <QtMath>
 #include <QColor>
+#include <QMutex>
+
+#include <vector>
 
 namespace Lottie {
 namespace {
@@ -255,6 +259,15 @@ void StopsBuilder::interpolateAlphaTill(int till) {
 
 } // namespace
 
+// Animated stops often keep their values for many frames, in holds or
+// after the animation ends, so the last built stops are kept.
+struct BMGFill::StopsCache {
+	QMutex mutex;
+	std::vector<double> key;
+	QGradientStops stops;
+	std::shared_ptr<const GradientTable> table;
+};
+
 BMGFill::BMGFill(BMBase *parent) : BMShape(parent) {
 }
 
@@ -266,7 +279,9 @@ BMGFill::BMGFill(BMBase *parent, const BMGFill &other)
 , m_highlightLength(other.m_highlightLength)
 , m_highlightAngle(other.m_highlightAngle)
 , m_colorStops(other.m_colorStops)
-, m_opacityStops(other.m_opacityStops) {
+, m_opacityStops(other.m_opacityStops)
+, m_table(other.m_table)
+, m_stopsCache(other.m_stopsCache) {
 	if (other.m_gradient) {
 		if (other.gradientType() == QGradient::LinearGradient) {
 			m_gradient = new QLinearGradient(*static_cast<QLinearGradient*>(other.m_gradient));
@@ -314,6 +329,8 @@ BMGFill::BMGFill(BMBase *parent, const JsonObject &definition)
 		parseAnimatedGradient(data, colorPoints);
 	} else if (m_gradient) {
 		m_gradient->setStops(StopsBuilder(data, colorPoints).result());
+		m_table = std::make_shared<const GradientTable>(
+			BuildGradientTable(m_gradient->stops()));
 	}
 
 	const auto opacity = definition.value("o").toObject();
@@ -433,6 +450,7 @@ void BMGFill::parseAnimatedGradient(const JsonArray &data, int colorPoints) {
 		m_opacityStops.push_back({});
 		m_opacityStops.back().constructAnimated(opacity);
 	}
+	m_stopsCache = std::make_shared<StopsCache>();
 }
 
 void BMGFill::updateProperties(int frame) {
@@ -462,6 +480,10 @@ QGradient *BMGFill::value() const {
 	return m_gradient;
 }
 
+std::shared_ptr<const GradientTable> BMGFill::table() const {
+	return m_table;
+}
+
 QGradient::Type BMGFill::gradientType() const {
 	if (m_gradient) {
 		return m_gradient->type();
@@ -491,8 +513,27 @@ qreal BMGFill::opacity() const {
 }
 
 void BMGFill::setGradientStops() {
-	m_gradient->setStops(
-		StopsBuilder(m_colorStops, m_opacityStops).result());
+	auto key = std::vector<double>();
+	key.reserve(m_colorStops.size() * 4 + m_opacityStops.size() * 2);
+	for (const auto &stop : m_colorStops) {
+		const auto value = stop.value();
+		key.insert(end(key), { value.x(), value.y(), value.z(), value.w() });
+	}
+	for (const auto &stop : m_opacityStops) {
+		const auto value = stop.value();
+		key.insert(end(key), { value.width(), value.height() });
+	}
+
+	QMutexLocker lock(&m_stopsCache->mutex);
+	auto &cache = *m_stopsCache;
+	if (!cache.table || cache.key != key) {
+		cache.key = std::move(key);
+		cache.stops = StopsBuilder(m_colorStops, m_opacityStops).result();
+		cache.table = std::make_shared<const GradientTable>(
+			BuildGradientTable(cache.stops));
+	}
+	m_gradient->setStops(cache.stops);
+	m_table = cache.table;
 }
 
 void BMGFill::setGradient() {
@@ -527,4 +568,20 @@ void BMGFill::setGradient() {
 	}
 }
 
+void BMGFill::analyze(Complexity &result) const {
+	++result.paints;
+	++result.gradients;
+	m_opacity.analyze(result);
+	m_startPoint.analyze(result);
+	m_endPoint.analyze(result);
+	m_highlightLength.analyze(result);
+	m_highlightAngle.analyze(result);
+	for (const auto &stop : m_colorStops) {
+		stop.analyze(result);
+	}
+	for (const auto &stop : m_opacityStops) {
+		stop.analyze(result);
+	}
+}
+
 } // namespace Lottie
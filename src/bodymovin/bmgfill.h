@@ -30,10 +30,13 @@
 
 #include "bmshape.h"
 #include "bmproperty.h"
+#include "gradienttable.h"
 
 #include <QList>
 #include <QGradient>
 
+#include <memory>
+
 namespace Lottie {
 
 class BMGFill : public BMShape {
@@ -47,8 +50,10 @@ public:
 
 	void updateProperties(int frame) override;
 	void render(Renderer &renderer, int frame) const override;
+	void analyze(Complexity &result) const override;
 
 	QGradient *value() const;
+	std::shared_ptr<const GradientTable> table() const;
 	QGradient::Type gradientType() const;
 	QPointF startPoint() const;
 	QPointF endPoint() const;
@@ -57,6 +62,8 @@ public:
 	qreal opacity() const;
 
 private:
+	struct StopsCache;
+
 	void setGradient();
 	void setGradientStops();
 	void parseAnimatedGradient(const JsonArray &data, int colorPoints);
@@ -72,6 +79,9 @@ private:
 	// Here width() holds time, height() holds opacity.
 	QVector<BMProperty<QSizeF>> m_opacityStops;
 	QGradient *m_gradient = nullptr;
+	std::shared_ptr<const GradientTable> m_table;
+	// Shared by the clones, set only for animated stops.
+	std::shared_ptr<StopsCache> m_stopsCache;
 
 };
 
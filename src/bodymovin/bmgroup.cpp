@@ -32,7 +32,10 @@
 #include "bmshape.h"
 #include "bmtrimpath.h"
 #include "bmbasictransform.h"
+#include "bmshapetransform.h"
 #include "renderer.h"
+#include "complexity.h"
+#include "bmrepeater.h"
 
 namespace Lottie {
 
@@ -76,7 +79,22 @@ void BMGroup::parse(const JsonObject &definition) {
 }
 
 void BMGroup::updateProperties(int frame) {
-	BMShape::updateProperties(frame);
+	// The transform goes first, see parse().
+	const auto transform = children().isEmpty()
+		? nullptr
+		: dynamic_cast<BMShapeTransform*>(children().front());
+	if (transform && transform->active(frame)) {
+		transform->updateProperties(frame);
+		m_transparent = transform->transparent();
+		if (m_transparent) {
+			return;
+		}
+	}
+	for (BMBase *child : children()) {
+		if (child != transform && child->active(frame)) {
+			child->updateProperties(frame);
+		}
+	}
 
 	for (BMBase *child : children()) {
 		if (!child->active(frame)) {
@@ -95,9 +113,16 @@ void BMGroup::updateProperties(int frame) {
 			shape->applyTrim(*m_appliedTrim);
 		}
 	}
+	if (m_appliedTrim && !m_appliedTrim->simultaneous()) {
+		m_appliedTrim->trimIndividually(children());
+	}
+	m_bounds = ContentBounds(children());
 }
 
 void BMGroup::render(Renderer &renderer, int frame) const {
+	if (m_transparent || (m_bounds && !renderer.visible(m_bounds->rect))) {
+		return;
+	}
 	renderer.saveState();
 
 	if (m_appliedTrim && !m_appliedTrim->hidden()) {
@@ -121,7 +146,7 @@ void BMGroup::render(Renderer &renderer, int frame) const {
 	if (m_appliedTrim
 		&& !m_appliedTrim->hidden()
 		&& !m_appliedTrim->simultaneous()) {
-		m_appliedTrim->render(renderer, frame);
+		renderer.render(*m_appliedTrim);
 	}
 
 	renderer.restoreState();
@@ -135,12 +160,28 @@ void BMGroup::applyTrim(const BMTrimPath &trimmer) {
 	Q_ASSERT_X(!m_appliedTrim, "BMGroup", "A trim already assigned");
 
 	m_appliedTrim = static_cast<BMTrimPath*>(trimmer.clone(this));
+	if (m_transparent) {
+		return;
+	}
 	for (BMBase *child : children()) {
 		BMShape *shape = static_cast<BMShape*>(child);
 		if (shape->acceptsTrim()) {
 			shape->applyTrim(*m_appliedTrim);
 		}
 	}
+	if (!m_appliedTrim->simultaneous()) {
+		m_appliedTrim->trimIndividually(children());
+	}
+}
+
+void BMGroup::analyze(Complexity &result) const {
+	auto contents = Complexity();
+	BMShape::analyze(contents);
+	const auto copies = BMRepeater::CopiesIn(*this);
+	result.append(contents, copies);
+	if (copies > 1) {
+		result.repeaterCopies += copies;
+	}
 }
 
 } // namespace Lottie
@@ -49,10 +49,15 @@ public:
 
 	void updateProperties(int frame) override;
 	void render(Renderer &renderer, int frame) const override;
+	void analyze(Complexity &result) const override;
 
 	bool acceptsTrim() const override;
 	void applyTrim(const BMTrimPath &trimmer) override;
 
+private:
+	// Contents of a fully transparent group are not even evaluated.
+	bool m_transparent = false;
+
 };
 
 } // namespace Lottie
@@ -36,6 +36,12 @@
 #include "bmprecomplayer.h"
 #include "bmmasks.h"
 #include "bmmaskshape.h"
+#include "parallel.h"
+#include "trackcache.h"
+#include "complexity.h"
+#include "bmrepeater.h"
+#include "layercache.h"
+#include "renderer.h"
 
 namespace Lottie {
 
@@ -52,6 +58,7 @@ BMLayer::BMLayer(BMBase *parent, const BMLayer &other)
 , m_3dLayer(other.m_3dLayer)
 , m_stretch(other.m_stretch)
 , m_layerTransform(this, other.m_layerTransform)
+, m_contentCache(other.m_contentCache)
 , m_parentLayer(other.m_parentLayer)
 , m_td(other.m_td)
 , m_clipMode(other.m_clipMode) {
@@ -78,6 +85,10 @@ BMLayer::~BMLayer() {
 
 BMLayer *BMLayer::construct(BMBase *parent, JsonObject definition) {
 	BMLayer *layer = nullptr;
+	const auto tracker = BudgetTracker::Current();
+	if (tracker && !tracker->addNode()) {
+		return layer;
+	}
 	int type = definition.value("ty").toInt();
 	switch (type) {
 	case 4:
@@ -95,6 +106,37 @@ BMLayer *BMLayer::construct(BMBase *parent, JsonObject definition) {
 	return layer;
 }
 
+std::vector<BMLayer*> BMLayer::constructAll(
+		BMBase *parent,
+		const JsonArray &definition) {
+	auto result = std::vector<BMLayer*>(definition.size(), nullptr);
+	const auto cache = TrackCache::Current();
+	const auto tracker = BudgetTracker::Current();
+	ParallelFor(result.size(), [&](int index) {
+		const auto scope = TrackCache::Scope(cache);
+		const auto budget = BudgetTracker::Scope(tracker);
+		result[index] = construct(parent, definition.at(index).toObject());
+	});
+	return result;
+}
+
+void BMLayer::appendAll(BMBase *parent, const std::vector<BMLayer*> &layers) {
+	for (auto i = layers.rbegin(); i != layers.rend(); ++i) {
+		const auto layer = *i;
+		if (!layer) {
+			continue;
+		}
+		// Mask layers must be rendered before the layers they affect to
+		// although they appear before in layer hierarchy. For this reason
+		// move a mask after the affected layers, so it will be rendered first
+		if (layer->isMaskLayer()) {
+			parent->prependChild(layer);
+		} else {
+			parent->appendChild(layer);
+		}
+	}
+}
+
 bool BMLayer::active(int frame) const {
 	return (!m_hidden && (frame >= m_startFrame && frame < m_endFrame));
 }
@@ -165,6 +207,12 @@ void BMLayer::updateProperties(int frame) {
 		}
 	}
 
+	// Contents of a fully transparent layer are not even evaluated.
+	m_layerTransform.updateProperties(frame);
+	if (m_layerTransform.transparent()) {
+		return;
+	}
+
 	// Update first effects, as they are not children of the layer
 	if (m_effects) {
 		for (BMBase* effect : m_effects->children()) {
@@ -179,8 +227,12 @@ void BMLayer::updateProperties(int frame) {
 	}
 
 	BMBase::updateProperties(frame);
+}
 
-	m_layerTransform.updateProperties(frame);
+void BMLayer::resolveAssets(
+		int frame,
+		const std::function<BMAsset*(BMBase*, QByteArray)> &resolver) {
+	// Only precomp layers reference assets, shapes never do.
 }
 
 BMLayer *BMLayer::resolveLinkedLayer() {
@@ -227,6 +279,30 @@ void BMLayer::renderFullTransform(Renderer &renderer, int frame) const {
 	m_layerTransform.renderWithoutOpacity(renderer, frame);
 }
 
+void BMLayer::renderContents(Renderer &renderer, int frame) const {
+	for (BMBase *child : children()) {
+		if (child->active(frame)) {
+			child->render(renderer, frame);
+		}
+	}
+}
+
+LayerCache *BMLayer::contentCache() const {
+	return m_contentCache.get();
+}
+
+bool BMLayer::renderTransparent(Renderer &renderer) const {
+	if (!m_layerTransform.transparent()) {
+		return false;
+	}
+	// Effects were not updated, but track mattes are still begun and
+	// finished, empty.
+	renderer.saveState();
+	renderer.render(*this);
+	renderer.restoreState();
+	return true;
+}
+
 void BMLayer::renderEffects(Renderer &renderer, int frame) const {
 	if (!m_effects) {
 		return;
@@ -288,4 +364,27 @@ void BMLayer::parseMasks(const JsonArray &definition) {
 	}
 }
 
+void BMLayer::analyze(Complexity &result) const {
+	++result.layers;
+	if (isClippedLayer()) {
+		++result.mattes;
+	}
+	m_layerTransform.analyze(result);
+	if (m_masks) {
+		result.masks += m_masks->children().size();
+		m_masks->analyze(result);
+	}
+	if (m_effects) {
+		m_effects->analyze(result);
+	}
+
+	auto contents = Complexity();
+	BMBase::analyze(contents);
+	const auto copies = BMRepeater::CopiesIn(*this);
+	result.append(contents, copies);
+	if (copies > 1) {
+		result.repeaterCopies += copies;
+	}
+}
+
 } // namespace Lottie
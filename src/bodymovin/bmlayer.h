@@ -31,9 +31,13 @@
 #include "bmbase.h"
 #include "bmbasictransform.h"
 
+#include <memory>
+#include <vector>
+
 namespace Lottie {
 
 class BMMasks;
+struct LayerCache;
 
 #define BM_LAYER_PRECOMP_IX 0x10000
 #define BM_LAYER_SOLID_IX   0x10001
@@ -52,11 +56,23 @@ public:
 
 	static BMLayer *construct(BMBase *parent, JsonObject definition);
 
+	// Layers don't depend on each other until linked, so they are built
+	// concurrently. Result keeps the definition order, nullptr on failure.
+	static std::vector<BMLayer*> constructAll(
+		BMBase *parent,
+		const JsonArray &definition);
+	// Appends in reverse order, mask layers go before the layers they affect.
+	static void appendAll(BMBase *parent, const std::vector<BMLayer*> &layers);
+
 	bool active(int frame) const override;
 
 	void parse(const JsonObject &definition) override;
 
 	void updateProperties(int frame) override;
+	void analyze(Complexity &result) const override;
+	void resolveAssets(
+		int frame,
+		const std::function<BMAsset*(BMBase*, QByteArray)> &resolver) override;
 
 	bool isClippedLayer() const;
 	bool isMaskLayer() const;
@@ -65,7 +81,15 @@ public:
 	int layerId() const;
 	void renderFullTransform(Renderer &renderer, int frame) const;
 
+	// Renders what the layer draws in its own coordinates.
+	virtual void renderContents(Renderer &renderer, int frame) const;
+
+	// Set only for layers with contents that are never animated.
+	LayerCache *contentCache() const;
+
 protected:
+	// True when the layer is fully transparent and nothing else is drawn.
+	bool renderTransparent(Renderer &renderer) const;
 	void renderEffects(Renderer &renderer, int frame) const;
 
 	virtual BMLayer *resolveLinkedLayer();
@@ -81,6 +105,7 @@ protected:
 	qreal m_stretch;
 	BMBasicTransform m_layerTransform;
 	BMMasks *m_masks = nullptr;
+	std::shared_ptr<LayerCache> m_contentCache;
 
 	int m_parentLayer = 0;
 	int m_td = 0;
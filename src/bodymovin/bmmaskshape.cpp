@@ -30,6 +30,7 @@
 
 #include "bmtrimpath.h"
 #include "renderer.h"
+#include "complexity.h"
 
 namespace Lottie {
 
@@ -38,7 +39,10 @@ BMMaskShape::BMMaskShape(BMBase *parent) : BMShape(parent) {
 
 BMMaskShape::BMMaskShape(BMBase *parent, const BMMaskShape &other)
 : BMShape(parent, other)
-, m_shape(other.m_shape) {
+, m_shape(other.m_shape)
+, m_inverted(other.m_inverted)
+, m_opacity(other.m_opacity)
+, m_mode(other.m_mode) {
 }
 
 BMMaskShape::BMMaskShape(BMBase *parent, const JsonObject &definition)
@@ -62,13 +66,11 @@ void BMMaskShape::parse(const JsonObject &definition) {
 		m_opacity.construct(opacity);
 	}
 
-	if (m_opacity.value() < 100. || m_opacity.animated()) {
-		qWarning() << "Transparent mask shapes are not supported.";
-	}
-
 	const auto mode = definition.value("mode").toString();
 	if (mode == "a") {
 		m_mode = Mode::Additive;
+	} else if (mode == "s") {
+		m_mode = Mode::Subtract;
 	} else if (mode == "i") {
 		m_mode = Mode::Intersect;
 	} else {
@@ -97,4 +99,15 @@ bool BMMaskShape::inverted() const {
 	return m_inverted;
 }
 
+qreal BMMaskShape::opacity() const {
+	return m_opacity.value();
+}
+
+void BMMaskShape::analyze(Complexity &result) const {
+	const auto animated = m_shape.vertexCount();
+	analyzeGeometry(result, animated ? animated : PathVertices(m_path));
+	m_shape.analyze(result);
+	m_opacity.analyze(result);
+}
+
 } // namespace Lottie
@@ -45,15 +45,18 @@ public:
 
 	void updateProperties(int frame) override;
 	void render(Renderer &renderer, int frame) const override;
+	void analyze(Complexity &result) const override;
 
 	enum class Mode {
 		Additive,
+		Subtract,
 		Intersect,
 	};
 
 	Mode mode() const;
 
 	bool inverted() const;
+	qreal opacity() const;
 
 protected:
 	FreeFormShape m_shape;
@@ -51,19 +51,7 @@ BMPreCompAsset::BMPreCompAsset(BMBase *parent, const JsonObject &definition)
 	}
 
 	const auto layers = definition.value("layers").toArray();
-	for (auto i = layers.end(); i != layers.begin();) {
-		const auto &entry = *(--i);
-		if (const auto layer = BMLayer::construct(this, entry.toObject())) {
-			// Mask layers must be rendered before the layers they affect to
-			// although they appear before in layer hierarchy. For this reason
-			// move a mask after the affected layers, so it will be rendered first
-			if (layer->isMaskLayer()) {
-				prependChild(layer);
-			} else {
-				appendChild(layer);
-			}
-		}
-	}
+	BMLayer::appendAll(this, BMLayer::constructAll(this, layers));
 }
 
 } // namespace Lottie
@@ -33,6 +33,7 @@
 #include "bmscene.h"
 #include "bmmasks.h"
 #include "renderer.h"
+#include "complexity.h"
 
 namespace Lottie {
 
@@ -40,7 +41,9 @@ BMPreCompLayer::BMPreCompLayer(BMBase *parent) : BMLayer(parent) {
 }
 
 BMPreCompLayer::BMPreCompLayer(BMBase *parent, const BMPreCompLayer &other)
-: BMLayer(parent, other) {
+: BMLayer(parent, other)
+, m_refId(other.m_refId)
+, m_unresolved(other.m_unresolved) {
 	if (other.m_layers) {
 		m_layers = other.m_layers->clone(this);
 	}
@@ -74,6 +77,9 @@ void BMPreCompLayer::updateProperties(int frame) {
 	}
 
 	BMLayer::updateProperties(frame);
+	if (m_layerTransform.transparent()) {
+		return;
+	}
 
 	const auto layersFrame = frame - m_startTime;
 	if (m_layers && m_layers->active(layersFrame)) {
@@ -82,6 +88,9 @@ void BMPreCompLayer::updateProperties(int frame) {
 }
 
 void BMPreCompLayer::render(Renderer &renderer, int frame) const {
+	if (renderTransparent(renderer)) {
+		return;
+	}
 	renderer.saveState();
 
 	renderEffects(renderer, frame);
@@ -97,26 +106,64 @@ void BMPreCompLayer::render(Renderer &renderer, int frame) const {
 		m_masks->render(renderer, frame);
 	}
 
+	renderContents(renderer, frame);
+
+	renderer.restoreState();
+}
+
+void BMPreCompLayer::renderContents(Renderer &renderer, int frame) const {
 	const auto layersFrame = frame - m_startTime;
 	if (m_layers && m_layers->active(layersFrame)) {
 		m_layers->render(renderer, layersFrame);
 	}
-
-	renderer.restoreState();
 }
 
 void BMPreCompLayer::resolveAssets(
+		int frame,
 		const std::function<BMAsset*(BMBase*, QByteArray)> &resolver) {
-	if (m_layers) {
-		return;
+	if (!m_layers && !m_unresolved) {
+		const auto depth = nestingDepth();
+		if (depth < 0) {
+			qWarning()
+				<< "BM PreComp Layer: recursive asset reference: "
+				<< QString::fromUtf8(m_refId);
+		} else if (topRoot()->checkPrecompDepth(depth)) {
+			m_layers = resolver(this, m_refId);
+			if (!m_layers) {
+				qWarning()
+					<< "BM PreComp Layer: asset not found: "
+					<< QString::fromUtf8(m_refId);
+			}
+		}
+		m_unresolved = !m_layers;
 	}
-	m_layers = resolver(this, m_refId);
-	if (!m_layers) {
-		qWarning()
-			<< "BM PreComp Layer: asset not found: "
-			<< QString::fromUtf8(m_refId);
+
+	const auto layersFrame = frame - m_startTime;
+	if (m_layers && m_layers->active(layersFrame)) {
+		m_layers->resolveAssets(layersFrame, resolver);
 	}
-	BMLayer::resolveAssets(resolver);
+}
+
+QByteArray BMPreCompLayer::refId() const {
+	return m_refId;
+}
+
+int BMPreCompLayer::nestingDepth() const {
+	auto result = 1;
+	for (auto i = parent(); i; i = i->parent()) {
+		if (i->type() == BM_LAYER_PRECOMP_IX) {
+			if (static_cast<BMPreCompLayer*>(i)->m_refId == m_refId) {
+				return -1;
+			}
+			++result;
+		}
+	}
+	return result;
+}
+
+void BMPreCompLayer::analyze(Complexity &result) const {
+	BMLayer::analyze(result);
+	topRoot()->analyzeAsset(m_refId, result);
 }
 
 } // namespace Lottie
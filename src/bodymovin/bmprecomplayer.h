@@ -43,14 +43,21 @@ public:
 
 	void updateProperties(int frame) override;
 	void render(Renderer &renderer, int frame) const override;
-	void resolveAssets(const std::function<BMAsset*(BMBase*, QByteArray)> &resolver) override;
+	void renderContents(Renderer &renderer, int frame) const override;
+	void analyze(Complexity &result) const override;
+	void resolveAssets(
+		int frame,
+		const std::function<BMAsset*(BMBase*, QByteArray)> &resolver) override;
 
 	QByteArray refId() const;
 
 private:
+	// Returns -1 if the layer is nested in a layer with the same refId.
+	int nestingDepth() const;
+
 	QByteArray m_refId;
 	BMBase *m_layers = nullptr;
-	bool m_resolving = false;
+	bool m_unresolved = false;
 
 };
 
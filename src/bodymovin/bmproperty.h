@@ -29,7 +29,9 @@
 #pragma once
 
 #include "beziereasing.h"
+#include "complexity.h"
 #include "json.h"
+#include "trackcache.h"
 
 #include <QPointF>
 #include <QSizeF>
@@ -193,24 +195,136 @@ ConstructAnimatedData<T> ParseAnimatedData(const JsonArray &keyframes) {
 	return result;
 }
 
+template <typename T>
+void AddToTrackHash(TrackHash &hash, const T &value) {
+	hash.add(value);
+}
+
+inline void AddToTrackHash(TrackHash &hash, const QPointF &value) {
+	hash.add(value.x());
+	hash.add(value.y());
+}
+
+inline void AddToTrackHash(TrackHash &hash, const QSizeF &value) {
+	hash.add(value.width());
+	hash.add(value.height());
+}
+
+inline void AddToTrackHash(TrackHash &hash, const QVector4D &value) {
+	hash.add(value.x());
+	hash.add(value.y());
+	hash.add(value.z());
+	hash.add(value.w());
+}
+
+template <typename T>
+quint64 HashTrack(const ConstructAnimatedData<T> &data) {
+	// Value types with equal sizes must not share hashes.
+	const auto tag = std::is_same_v<T, QPointF>
+		? 'p'
+		: std::is_same_v<T, QSizeF>
+		? 's'
+		: std::is_same_v<T, QVector4D>
+		? 'v'
+		: std::is_same_v<T, int>
+		? 'i'
+		: 'r';
+	auto result = TrackHash();
+	result.add(tag);
+	for (const auto &keyframe : data.keyframes) {
+		AddToTrackHash(result, keyframe.startValue);
+		AddToTrackHash(result, keyframe.endValue);
+		AddToTrackHash(result, keyframe.startFrame);
+		AddToTrackHash(result, keyframe.easingIn);
+		AddToTrackHash(result, keyframe.easingOut);
+		AddToTrackHash(result, keyframe.hold);
+		if constexpr (std::is_same_v<T, QPointF>) {
+			AddToTrackHash(result, keyframe.tangentIn);
+			AddToTrackHash(result, keyframe.tangentOut);
+		}
+	}
+	return result.value();
+}
+
+// Exact comparisons, the Qt operators for points and sizes are fuzzy.
+template <typename T>
+bool SameTrackValue(const T &a, const T &b) {
+	return (a == b);
+}
+
+inline bool SameTrackValue(const QPointF &a, const QPointF &b) {
+	return (a.x() == b.x()) && (a.y() == b.y());
+}
+
+inline bool SameTrackValue(const QSizeF &a, const QSizeF &b) {
+	return (a.width() == b.width()) && (a.height() == b.height());
+}
+
+inline bool SameTrackValue(const QVector4D &a, const QVector4D &b) {
+	return (a.x() == b.x())
+		&& (a.y() == b.y())
+		&& (a.z() == b.z())
+		&& (a.w() == b.w());
+}
+
+template <typename T>
+bool SameTrack(
+		const QVector<EasingSegment<T>> &a,
+		const QVector<EasingSegment<T>> &b) {
+	if (a.size() != b.size()) {
+		return false;
+	}
+	for (auto i = 0; i != a.size(); ++i) {
+		const auto &first = a[i];
+		const auto &second = b[i];
+		if (first.startFrame != second.startFrame
+			|| first.endFrame != second.endFrame
+			|| !SameTrackValue(first.startValue, second.startValue)
+			|| !SameTrackValue(first.endValue, second.endValue)
+			|| !first.easing.same(second.easing)) {
+			return false;
+		}
+		if constexpr (std::is_same_v<T, QPointF>) {
+			if (first.bezierLength != second.bezierLength
+				|| first.bezierPoints.size() != second.bezierPoints.size()) {
+				return false;
+			}
+			for (auto j = 0; j != first.bezierPoints.size(); ++j) {
+				const auto &point = first.bezierPoints[j];
+				const auto &other = second.bezierPoints[j];
+				if (!SameTrackValue(point.point, other.point)
+					|| point.length != other.length) {
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
 template<typename T>
 class BMProperty final {
 public:
 	void constructAnimated(const ConstructAnimatedData<T> &data) {
 		m_animated = true;
 
-		const auto &list = data.keyframes;
-		m_easingCurves.reserve(list.size());
-		const auto b = begin(list);
-		const auto e = end(list);
-		for (auto i = b; i != e; ++i) {
-			const auto prev = (i == b) ? i : (i - 1);
-			const auto next = i + 1;
-			m_easingCurves.push_back(createEasing(
-				(prev != i) ? &*prev : nullptr,
-				*i,
-				(next != e) ? &*next : nullptr));
-		}
+		// Equal tracks are shared by the whole scene, they are immutable
+		// except for the spatial lookup hints, which are valid for any user.
+		using Curves = QVector<EasingSegment<T>>;
+		m_easingCurves = Deduplicated<Curves>(HashTrack(data), [&] {
+			return createEasingCurves(data);
+		}, [](const Curves &a, const Curves &b) {
+			return SameTrack(a, b);
+		}, [](const Curves &curves) {
+			auto result = qint64(curves.size()) * sizeof(EasingSegment<T>);
+			if constexpr (std::is_same_v<T, QPointF>) {
+				for (const auto &segment : curves) {
+					result += segment.bezierPoints.size()
+						* sizeof(EasingSegment<QPointF>::BezierPoint);
+				}
+			}
+			return result;
+		});
 		if (!m_easingCurves.empty()) {
 			m_startFrame = std::round(m_easingCurves.front().startFrame);
 			m_endFrame = std::round(m_easingCurves.back().endFrame);
@@ -247,6 +361,27 @@ public:
 		return m_animated;
 	}
 
+	template <typename Method>
+	void enumerateValues(Method &&method) const {
+		if (!m_animated) {
+			method(m_value);
+			return;
+		}
+		for (const auto &segment : m_easingCurves) {
+			method(segment.startValue);
+			method(segment.endValue);
+		}
+	}
+
+	void analyze(Complexity &result) const {
+		if (m_animated) {
+			++result.animatedProperties;
+			result.maxKeyframes = std::max(
+				result.maxKeyframes,
+				int(m_easingCurves.size()));
+		}
+	}
+
 	bool update(int frame) {
 		if (!m_animated) {
 			return false;
@@ -262,6 +397,24 @@ public:
 	}
 
 private:
+	QVector<EasingSegment<T>> createEasingCurves(
+			const ConstructAnimatedData<T> &data) const {
+		auto result = QVector<EasingSegment<T>>();
+		const auto &list = data.keyframes;
+		result.reserve(list.size());
+		const auto b = begin(list);
+		const auto e = end(list);
+		for (auto i = b; i != e; ++i) {
+			const auto prev = (i == b) ? i : (i - 1);
+			const auto next = i + 1;
+			result.push_back(createEasing(
+				(prev != i) ? &*prev : nullptr,
+				*i,
+				(next != e) ? &*next : nullptr));
+		}
+		return result;
+	}
+
 	const EasingSegment<T> *getEasingSegment(int frame) const {
 		if (m_easingCurves.empty()) {
 			qWarning()
@@ -328,7 +481,7 @@ private:
 	EasingSegment<T> createEasing(
 			const ConstructKeyframeData<T> *prev,
 			const ConstructKeyframeData<T> &data,
-			const ConstructKeyframeData<T> *next) {
+			const ConstructKeyframeData<T> *next) const {
 		auto result = EasingSegment<T>();
 		result.startFrame = data.startFrame;
 		result.endFrame = next ? next->startFrame : data.startFrame;
@@ -30,6 +30,7 @@
 
 #include "bmtrimpath.h"
 #include "renderer.h"
+#include "complexity.h"
 
 namespace Lottie {
 
@@ -109,4 +110,15 @@ qreal BMRect::roundness() const {
 	return m_roundness.value();
 }
 
+void BMRect::analyze(Complexity &result) const {
+	auto rounded = false;
+	m_roundness.enumerateValues([&](qreal roundness) {
+		rounded = rounded || (roundness > 0.);
+	});
+	analyzeGeometry(result, rounded ? 8 : 4);
+	m_position.analyze(result);
+	m_size.analyze(result);
+	m_roundness.analyze(result);
+}
+
 } // namespace Lottie
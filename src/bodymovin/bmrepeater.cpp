@@ -29,6 +29,8 @@
 #include "bmrepeater.h"
 
 #include "renderer.h"
+#include "complexity.h"
+#include "bmscene.h"
 
 namespace Lottie {
 
@@ -66,6 +68,10 @@ void BMRepeater::parse(const JsonObject &definition) {
 
 void BMRepeater::updateProperties(int frame) {
 	m_copies.update(frame);
+	const auto maxCopies = topRoot()->budget().maxRepeaterCopies;
+	if (m_copies.value() > maxCopies) {
+		m_copies.setValue(maxCopies);
+	}
 	m_offset.update(frame);
 	m_transform.setInstanceCount(m_copies.value());
 	m_transform.updateProperties(frame);
@@ -87,4 +93,29 @@ const BMRepeaterTransform &BMRepeater::transform() const {
 	return m_transform;
 }
 
+int BMRepeater::maxCopies() const {
+	auto result = 0;
+	m_copies.enumerateValues([&](int copies) {
+		result = std::max(result, copies);
+	});
+	return result;
+}
+
+void BMRepeater::analyze(Complexity &result) const {
+	m_copies.analyze(result);
+	m_offset.analyze(result);
+	m_transform.analyze(result);
+}
+
+int BMRepeater::CopiesIn(const BMBase &container) {
+	auto result = 1;
+	for (BMBase *child : container.children()) {
+		if (child->type() == BM_SHAPE_REPEATER_IX && !child->hidden()) {
+			result = Saturate(
+				qint64(result) * static_cast<BMRepeater*>(child)->maxCopies());
+		}
+	}
+	return result;
+}
+
 } // namespace Lottie
@@ -42,12 +42,17 @@ public:
 
 	BMBase *clone(BMBase *parent) const override;
 
+	// Product of the largest copy counts of the repeaters in container.
+	static int CopiesIn(const BMBase &container);
+
 	void parse(const JsonObject &definition) override;
 
 	void updateProperties(int frame) override;
 	void render(Renderer &renderer, int frame) const override;
+	void analyze(Complexity &result) const override;
 
 	int copies() const;
+	int maxCopies() const;
 	qreal offset() const;
 	const BMRepeaterTransform &transform() const;
 
@@ -29,6 +29,7 @@
 #include "bmrepeatertransform.h"
 
 #include "renderer.h"
+#include "complexity.h"
 
 namespace Lottie {
 
@@ -38,8 +39,7 @@ BMRepeaterTransform::BMRepeaterTransform(BMBase *parent) : BMBasicTransform(pare
 BMRepeaterTransform::BMRepeaterTransform(BMBase *parent, const BMRepeaterTransform &other)
 : BMBasicTransform(parent, other)
 , m_startOpacity(other.m_startOpacity)
-, m_endOpacity(other.m_endOpacity)
-, m_opacities(other.m_opacities) {
+, m_endOpacity(other.m_endOpacity) {
 }
 
 BMRepeaterTransform::BMRepeaterTransform(BMBase *parent, const JsonObject &definition)
@@ -69,13 +69,6 @@ void BMRepeaterTransform::updateProperties(int frame) {
 
 	m_startOpacity.update(frame);
 	m_endOpacity.update(frame);
-
-	m_opacities.clear();
-	for (int i = 0; i < m_copies; i++) {
-		const auto opacity = m_startOpacity.value()
-			+ (m_endOpacity.value() - m_startOpacity.value()) * i / m_copies;
-		m_opacities.push_back(opacity);
-	}
 }
 
 void BMRepeaterTransform::render(Renderer &renderer, int frame) const {
@@ -87,7 +80,11 @@ void BMRepeaterTransform::setInstanceCount(int copies) {
 }
 
 qreal BMRepeaterTransform::opacityAtInstance(int instance) const {
-	return m_opacities.at(instance) / 100.0;
+	Q_ASSERT(instance >= 0 && instance < m_copies);
+
+	const auto opacity = m_startOpacity.value()
+		+ (m_endOpacity.value() - m_startOpacity.value()) * instance / m_copies;
+	return opacity / 100.0;
 }
 
 qreal BMRepeaterTransform::startOpacity() const {
@@ -98,4 +95,10 @@ qreal BMRepeaterTransform::endOpacity() const {
 	return m_endOpacity.value();
 }
 
+void BMRepeaterTransform::analyze(Complexity &result) const {
+	BMBasicTransform::analyze(result);
+	m_startOpacity.analyze(result);
+	m_endOpacity.analyze(result);
+}
+
 } // namespace Lottie
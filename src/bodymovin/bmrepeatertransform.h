@@ -47,6 +47,7 @@ public:
 
 	void updateProperties(int frame) override;
 	void render(Renderer &renderer, int frame) const override;
+	void analyze(Complexity &result) const override;
 
 	qreal startOpacity() const;
 	qreal endOpacity() const;
@@ -58,7 +59,6 @@ protected:
 	int m_copies = 0;
 	BMProperty<qreal> m_startOpacity;
 	BMProperty<qreal> m_endOpacity;
-	QList<qreal> m_opacities;
 
 };
 
@@ -30,6 +30,7 @@
 
 #include "bmtrimpath.h"
 #include "renderer.h"
+#include "complexity.h"
 
 namespace Lottie {
 
@@ -101,4 +102,9 @@ qreal BMRound::radius() const {
 	return m_radius.value();
 }
 
+void BMRound::analyze(Complexity &result) const {
+	m_position.analyze(result);
+	m_radius.analyze(result);
+}
+
 } // namespace Lottie
@@ -30,16 +30,95 @@
 
 #include "bmasset.h"
 #include "bmlayer.h"
+#include "json.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <limits>
 
 namespace Lottie {
 namespace {
 
 constexpr auto kMaxFrameRate = 120;
 constexpr auto kMaxSize = 3096;
+constexpr auto kMaxNodesTotal = qint64(std::numeric_limits<int>::max());
+
+[[nodiscard]] int MaxCopies(const JsonValue &property) {
+	auto result = 0.;
+	const auto value = property.toObject().value("k");
+	if (value.isArray()) {
+		for (const auto &entry : value.toArray()) {
+			if (entry.isObject()) {
+				const auto keyframe = entry.toObject();
+				result = std::max({
+					result,
+					keyframe.value("s").toArray().at(0).toDouble(),
+					keyframe.value("e").toArray().at(0).toDouble() });
+			} else {
+				result = std::max(result, entry.toDouble());
+			}
+		}
+	} else {
+		result = value.toDouble();
+	}
+	return int(std::clamp(result, 0., double(kMaxNodesTotal)));
+}
+
+qint64 ScanNodes(const JsonValue &value, Complexity *elements);
+
+// Counts the nodes in a list of layers or shapes, optionally finding the
+// largest elements, the same way BMShape::construct will check them.
+qint64 ScanNodes(const JsonArray &list, bool nodes, Complexity *elements) {
+	auto result = nodes ? qint64(list.size()) : qint64();
+	for (const auto &entry : list) {
+		result = std::min(result + ScanNodes(entry, elements), kMaxNodesTotal);
+	}
+	return result;
+}
+
+qint64 ScanNodes(const JsonValue &value, Complexity *elements) {
+	if (value.isArray()) {
+		return ScanNodes(value.toArray(), false, elements);
+	} else if (!value.isObject()) {
+		return 0;
+	}
+	const auto object = value.toObject();
+	if (elements) {
+		const auto keyframes = object.value("k");
+		if (keyframes.isArray() && object.value("a").toInt() == 1) {
+			elements->maxKeyframes = std::max(
+				elements->maxKeyframes,
+				int(keyframes.toArray().size()));
+		}
+		const auto vertices = object.value("v");
+		if (vertices.isArray() && object.contains("i")) {
+			elements->maxPathVertices = std::max(
+				elements->maxPathVertices,
+				int(vertices.toArray().size()));
+		}
+		if (object.value("ty").toString() == "rp") {
+			elements->repeaterCopies = std::max(
+				elements->repeaterCopies,
+				MaxCopies(object.value("c")));
+		}
+	}
+	auto result = qint64();
+	for (const auto &member : object) {
+		const auto name = member.name().toString();
+		const auto value = member.value();
+		result += (name == "shapes" || name == "it")
+			? ScanNodes(value.toArray(), true, elements)
+			: ScanNodes(value, elements);
+		result = std::min(result, kMaxNodesTotal);
+	}
+	return result;
+}
 
 } // namespace
 
-BMScene::BMScene(const JsonObject &definition) : BMBase(nullptr) {
+BMScene::BMScene(const JsonObject &definition, const Budget &budget)
+: BMBase(nullptr)
+, _budget(budget) {
 	parse(definition);
 }
 
@@ -62,7 +141,8 @@ bool BMScene::isValid() const {
 		&& (_width > 0)
 		&& (_width <= kMaxSize)
 		&& (_height > 0)
-		&& (_height <= kMaxSize);
+		&& (_height <= kMaxSize)
+		&& !_budget.exceeded();
 }
 
 int BMScene::startFrame() const {
@@ -85,8 +165,14 @@ int BMScene::height() const {
 	return _height;
 }
 
+qint64 BMScene::deduplicatedBytes() const {
+	return _trackCache.savedBytes();
+}
+
 void BMScene::parse(const JsonObject &definition) {
 	_parsing = true;
+	const auto scope = TrackCache::Scope(&_trackCache);
+	const auto budget = BudgetTracker::Scope(&_budget);
 
 	_startFrame = definition.value("ip").toInt();
 	_endFrame = definition.value("op").toInt();
@@ -95,43 +181,45 @@ void BMScene::parse(const JsonObject &definition) {
 	_height = definition.value("h").toInt();
 
 	const auto assets = definition.value("assets").toArray();
+	auto precomps = std::vector<JsonObject>();
 	for (const auto &entry : assets) {
-		if (const auto asset = BMAsset::construct(this, entry.toObject())) {
-			_assetIndexById.insert(asset->id(), _assets.size());
-			_assets.emplace_back(asset);
+		const auto asset = entry.toObject();
+		if (asset.contains("layers")) {
+			_assetIndexById.insert(asset.value("id").toString(), precomps.size());
+			precomps.push_back(asset);
 		} else {
 			_unsupported = true;
 		}
 	}
+	_assets.resize(precomps.size());
+	ParallelFor(precomps.size(), [&](int index) {
+		_assets[index].json = precomps[index].serialize();
+	});
 
 	if (!definition.value("chars").toArray().empty()) {
 		_unsupported = true;
 	}
 
+	checkPrecomps(precomps, definition.value("layers").toArray());
+
 	_blueprint = std::make_unique<BMBase>(this);
-	const auto layers = definition.value("layers").toArray();
-	for (auto i = layers.end(); i != layers.begin();) {
-		const auto &entry = *(--i);
-		if (const auto layer = BMLayer::construct(_blueprint.get(), entry.toObject())) {
-			// Mask layers must be rendered before the layers they affect to
-			// although they appear before in layer hierarchy. For this reason
-			// move a mask after the affected layers, so it will be rendered first
-			if (layer->isMaskLayer()) {
-				_blueprint->prependChild(layer);
-			} else {
-				_blueprint->appendChild(layer);
-			}
-		} else {
-			_unsupported = true;
-		}
+	const auto layers = BMLayer::constructAll(
+		_blueprint.get(),
+		definition.value("layers").toArray());
+	if (std::find(begin(layers), end(layers), nullptr) != end(layers)) {
+		_unsupported = true;
 	}
-
-	resolveAllAssets();
+	BMLayer::appendAll(_blueprint.get(), layers);
 
 	_parsing = false;
 }
 
 void BMScene::updateProperties(int frame) {
+	// Resolve in the blueprint, so that the assets are constructed only once.
+	_blueprint->resolveAssets(frame, [&](BMBase *parent, QByteArray refId) {
+		return resolveAsset(parent, refId);
+	});
+
 	_current.reset(_blueprint->clone(this));
 	_current->updateProperties(frame);
 }
@@ -141,31 +229,121 @@ void BMScene::render(Renderer &renderer, int frame) const {
 	_current->render(renderer, frame);
 }
 
-void BMScene::resolveAllAssets() {
-	if (_assets.empty()) {
-		return;
+BMAsset *BMScene::resolveAsset(BMBase *parent, const QByteArray &refId) {
+	const auto i = _assetIndexById.constFind(refId);
+	if (i == _assetIndexById.constEnd()) {
+		return nullptr;
+	}
+	const auto asset = construct(_assets[i.value()]);
+	return asset ? asset->clone(parent) : nullptr;
+}
+
+BMAsset *BMScene::construct(Asset &asset) {
+	if (!asset.constructed && !asset.json.isEmpty()) {
+		const auto scope = TrackCache::Scope(&_trackCache);
+		const auto budget = BudgetTracker::Scope(&_budget);
+		const auto document = JsonDocument(std::move(asset.json));
+		asset.constructed.reset(BMAsset::construct(this, document.root()));
 	}
+	return asset.constructed.get();
+}
 
-	std::function<BMAsset*(BMBase*, QString)> resolver = [&](BMBase *parent, const QString &refId)
-		-> BMAsset * {
-		const auto i = _assetIndexById.constFind(refId);
-		if (i == _assetIndexById.constEnd()) {
-			return nullptr;
+void BMScene::checkPrecomps(
+		const std::vector<JsonObject> &precomps,
+		const JsonArray &layers) {
+	const auto references = [&](const JsonArray &list) {
+		auto result = std::vector<int>();
+		for (const auto &entry : list) {
+			const auto layer = entry.toObject();
+			if (layer.value("ty").toInt() != 0
+				|| layer.value("hd").toBool()) {
+				continue;
+			}
+			const auto refId = layer.value("refId").toString();
+			const auto i = _assetIndexById.constFind(refId);
+			if (i != _assetIndexById.constEnd()) {
+				result.push_back(i.value());
+			}
+		}
+		return result;
+	};
+
+	// Totals of each precomp with all of its nested instances, found from
+	// the JSON so that the limits are enforced before any asset is built.
+	struct Totals {
+		int depth = 0;
+		qint64 nodes = 0;
+	};
+	enum class State { Unknown, Visiting, Known };
+	auto states = std::vector<State>(precomps.size(), State::Unknown);
+	auto totals = std::vector<Totals>(precomps.size());
+	const auto instantiate = [&](
+			const JsonArray &list,
+			Complexity *elements,
+			const auto &self) -> Totals {
+		auto result = Totals{ 0, ScanNodes(list, true, elements) };
+		for (const auto index : references(list)) {
+			if (states[index] == State::Visiting) {
+				continue; // Recursive references are never rendered.
+			} else if (states[index] == State::Unknown) {
+				states[index] = State::Visiting;
+				const auto nested = precomps[index].value("layers").toArray();
+				auto own = Complexity();
+				auto &asset = totals[index];
+				asset = self(nested, &own, self);
+				_budget.check(own);
+				++asset.depth;
+				states[index] = State::Known;
+			}
+			result.depth = std::max(result.depth, totals[index].depth);
+			result.nodes = std::min(
+				result.nodes + totals[index].nodes,
+				kMaxNodesTotal);
 		}
-		const auto result = _assets[i.value()].get();
-		result->resolveAssets(resolver);
-		return result->clone(parent);
+		return result;
 	};
-	for (const auto &asset : _assets) {
-		asset->resolveAssets(resolver);
+	// Elements of the root layers are checked by BMShape::construct.
+	const auto result = instantiate(layers, nullptr, instantiate);
+	_budget.checkPrecompDepth(result.depth);
+	_budget.checkInstantiatedNodes(result.nodes);
+}
+
+const Budget &BMScene::budget() const {
+	return _budget.budget();
+}
+
+bool BMScene::checkPrecompDepth(int depth) {
+	return _budget.checkPrecompDepth(depth);
+}
+
+Complexity BMScene::analyze() {
+	auto result = Complexity();
+	if (_blueprint) {
+		_blueprint->analyze(result);
 	}
+	return result;
+}
 
-	_blueprint->resolveAssets([&](BMBase *parent, const QString &refId) {
-		const auto i = _assetIndexById.constFind(refId);
-		return (i != _assetIndexById.constEnd())
-			? _assets[i.value()]->clone(parent)
-			: nullptr;
-	});
+void BMScene::analyzeAsset(const QByteArray &refId, Complexity &result) {
+	const auto i = _assetIndexById.constFind(refId);
+	if (i == _assetIndexById.constEnd()) {
+		return;
+	}
+	auto &asset = _assets[i.value()];
+	if (asset.analyzing) {
+		// Recursive reference, it is never rendered.
+		return;
+	} else if (!asset.complexity) {
+		auto complexity = Complexity();
+		if (const auto constructed = construct(asset)) {
+			asset.analyzing = true;
+			constructed->analyze(complexity);
+			asset.analyzing = false;
+		}
+		++complexity.precompDepth;
+		asset.complexity = complexity;
+	}
+	result.append(*asset.complexity);
 }
 
 } // namespace Lottie
@@ -29,20 +29,26 @@
 #pragma once
 
 #include "bmbase.h"
+#include "complexity.h"
+#include "trackcache.h"
 
 #include <QHash>
 #include <vector>
 #include <memory>
+#include <optional>
 
 namespace Lottie {
 
 class BMAsset;
+class JsonArray;
 
 class BMScene : public BMBase {
 public:
 	BMScene(const BMScene &other) = delete;
 	BMScene &operator=(const BMScene &other) = delete;
-	explicit BMScene(const JsonObject &definition);
+	explicit BMScene(
+		const JsonObject &definition,
+		const Budget &budget = Budget());
 	virtual ~BMScene();
 
 	BMBase *clone(BMBase *parent) const override;
@@ -50,6 +56,9 @@ public:
 	void updateProperties(int frame) override;
 	void render(Renderer &renderer, int frame) const override;
 
+	// Precomp assets are built from their JSON on the first request.
+	BMAsset *resolveAsset(BMBase *parent, const QByteArray &refId);
+
 	bool isValid() const;
 	int startFrame() const;
 	int endFrame() const;
@@ -57,15 +66,38 @@ public:
 	int width() const;
 	int height() const;
 
+	// Memory not allocated thanks to sharing of identical keyframe tracks,
+	// net of what the sharing cache itself takes.
+	qint64 deduplicatedBytes() const;
+
+	// Walks the whole composition, constructing all referenced assets.
+	Complexity analyze();
+	void analyzeAsset(const QByteArray &refId, Complexity &result);
+
+	const Budget &budget() const;
+	bool checkPrecompDepth(int depth);
+
 protected:
 	BMScene *resolveTopRoot() const override;
 
 private:
-	void parse(const JsonObject &definition) override;
-	void resolveAllAssets();
+	struct Asset {
+		QByteArray json;
+		std::unique_ptr<BMAsset> constructed;
+		std::optional<Complexity> complexity;
+		bool analyzing = false;
+	};
 
-	std::vector<std::unique_ptr<BMAsset>> _assets;
-	QHash<QString, int> _assetIndexById;
+	void parse(const JsonObject &definition) override;
+	BMAsset *construct(Asset &asset);
+	void checkPrecomps(
+		const std::vector<JsonObject> &precomps,
+		const JsonArray &layers);
+
+	BudgetTracker _budget;
+	TrackCache _trackCache;
+	std::vector<Asset> _assets;
+	QHash<QByteArray, int> _assetIndexById;
 
 	std::unique_ptr<BMBase> _blueprint;
 	std::unique_ptr<BMBase> _current;
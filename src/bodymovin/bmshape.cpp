@@ -39,6 +39,10 @@
 #include "bmshapetransform.h"
 #include "bmfreeformshape.h"
 #include "bmrepeater.h"
+#include "complexity.h"
+#include "trimpath.h"
+
+#include <cmath>
 
 namespace Lottie {
 
@@ -49,7 +53,8 @@ BMShape::BMShape(BMBase *parent, const BMShape &other)
 : BMBase(parent, other)
 , m_path(other.m_path)
 , m_appliedTrim(other.m_appliedTrim)
-, m_direction(other.m_direction) {
+, m_direction(other.m_direction)
+, m_lengthCache(other.m_lengthCache) {
 }
 
 BMBase *BMShape::clone(BMBase *parent) const {
@@ -58,6 +63,10 @@ BMBase *BMShape::clone(BMBase *parent) const {
 
 BMShape *BMShape::construct(BMBase *parent, const JsonObject &definition) {
     BMShape *shape = nullptr;
+    const auto tracker = BudgetTracker::Current();
+    if (tracker && !tracker->addNode()) {
+        return shape;
+    }
     const auto type = definition.value("ty").toString();
 
     if (Q_UNLIKELY(type.size() != 2)) {
@@ -134,6 +143,19 @@ BMShape *BMShape::construct(BMBase *parent, const JsonObject &definition) {
 
 #undef BM_SHAPE_TAG
 
+    // Group contents were checked when they were constructed.
+    if (shape && tracker && shape->type() != BM_SHAPE_GROUP_IX) {
+        auto complexity = Complexity();
+        shape->analyze(complexity);
+        if (shape->type() == BM_SHAPE_REPEATER_IX) {
+            complexity.repeaterCopies = static_cast<BMRepeater*>(shape)->maxCopies();
+        }
+        if (!tracker->check(complexity)) {
+            delete shape;
+            return nullptr;
+        }
+    }
+
     return shape;
 }
 
@@ -143,7 +165,29 @@ bool BMShape::acceptsTrim() const {
 
 void BMShape::applyTrim(const BMTrimPath &trimmer) {
 	if (trimmer.simultaneous()) {
-		m_path = trimmer.trim(m_path);
+		m_path = trimmer.trim(m_path, m_lengthCache.get());
+	}
+}
+
+void BMShape::SetupLengthCaches(
+		const QList<BMBase*> &elements,
+		bool trimmed) {
+	// A trim applies to the elements after it, see updateProperties().
+	for (BMBase *element : elements) {
+		const auto shape = dynamic_cast<BMShape*>(element);
+		if (!shape || shape->hidden()) {
+			continue;
+		} else if (shape->type() == BM_SHAPE_TRIM_IX) {
+			trimmed = true;
+		} else if (shape->type() == BM_SHAPE_GROUP_IX) {
+			SetupLengthCaches(shape->children(), trimmed);
+		} else if (trimmed && shape->acceptsTrim()) {
+			auto complexity = Complexity();
+			shape->analyze(complexity);
+			if (!complexity.animatedProperties) {
+				shape->m_lengthCache = std::make_shared<PathLengthCache>();
+			}
+		}
 	}
 }
 
@@ -155,4 +199,92 @@ const QPainterPath &BMShape::path() const {
     return m_path;
 }
 
+std::optional<BMShape::Bounds> BMShape::ContentBounds(
+		const QList<BMBase*> &elements) {
+	auto result = Bounds();
+	auto extent = 0.;
+	auto transform = QTransform();
+	auto empty = true;
+
+	// QRectF::united() skips empty rects, but a point may be stroked.
+	const auto add = [&](const QRectF &rect) {
+		result.rect = empty ? rect : QRectF(
+			QPointF(
+				std::min(result.rect.left(), rect.left()),
+				std::min(result.rect.top(), rect.top())),
+			QPointF(
+				std::max(result.rect.right(), rect.right()),
+				std::max(result.rect.bottom(), rect.bottom())));
+		empty = false;
+	};
+	for (const auto element : elements) {
+		if (element->hidden()) {
+			continue;
+		}
+		const auto shape = dynamic_cast<const BMShape*>(element);
+		if (!shape) {
+			return std::nullopt;
+		}
+		switch (shape->type()) {
+		case BM_SHAPE_REPEATER_IX:
+			return std::nullopt;
+		case BM_SHAPE_GROUP_IX: {
+			const auto &bounds = shape->bounds();
+			if (!bounds) {
+				return std::nullopt;
+			}
+			add(bounds->rect);
+			result.scale = std::max(result.scale, bounds->scale);
+		} break;
+		case BM_SHAPE_STROKE_IX:
+			extent = std::max(
+				extent,
+				static_cast<const BMStroke*>(shape)->extent());
+			break;
+		case BM_SHAPE_TRANS_IX:
+			transform = static_cast<const BMShapeTransform*>(
+				shape)->apply(QTransform());
+			break;
+		case BM_SHAPE_TRIM_IX:
+			break;
+		default:
+			if (shape->acceptsTrim() && !shape->path().isEmpty()) {
+				add(shape->path().controlPointRect());
+			}
+			break;
+		}
+	}
+	// The strokes apply to the nested groups, enlarged by their scale.
+	const auto outset = extent * result.scale;
+	result.rect = transform.mapRect(result.rect.adjusted(
+		-outset,
+		-outset,
+		outset,
+		outset));
+	result.scale *= std::max(
+		std::hypot(transform.m11(), transform.m12()),
+		std::hypot(transform.m21(), transform.m22()));
+	return result;
+}
+
+const std::optional<BMShape::Bounds> &BMShape::bounds() const {
+	return m_bounds;
+}
+
+int BMShape::PathVertices(const QPainterPath &path) {
+	auto result = 0;
+	for (auto i = 0, count = path.elementCount(); i != count; ++i) {
+		if (path.elementAt(i).type != QPainterPath::CurveToDataElement) {
+			++result;
+		}
+	}
+	return result;
+}
+
+void BMShape::analyzeGeometry(Complexity &result, int vertices) const {
+	++result.shapes;
+	result.vertices += vertices;
+	result.maxPathVertices = std::max(result.maxPathVertices, vertices);
+}
+
 } // namespace Lottie
@@ -31,10 +31,15 @@
 #include "bmbase.h"
 
 #include <QPainterPath>
+#include <QRectF>
+
+#include <memory>
+#include <optional>
 
 namespace Lottie {
 
 class BMTrimPath;
+class PathLengthCache;
 
 #define BM_SHAPE_ANY_TYPE_IX -1
 #define BM_SHAPE_ELLIPSE_IX  0x00000
@@ -60,6 +65,24 @@ public:
 
 	static BMShape *construct(BMBase *parent, const JsonObject &definition);
 
+	// Where the shapes are drawn, in the coordinates of the parent of the
+	// elements, so after their transform, with their strokes included.
+	// The scale tells how much the transforms inside may enlarge strokes
+	// applied from outside. Unknown with repeaters, which draw copies.
+	struct Bounds {
+		QRectF rect;
+		qreal scale = 1.;
+	};
+	static std::optional<Bounds> ContentBounds(
+		const QList<BMBase*> &elements);
+	const std::optional<Bounds> &bounds() const;
+
+	// Gives the static shapes reached by a trim a cache of their lengths,
+	// trimmed tells whether a trim of the container applies to them.
+	static void SetupLengthCaches(
+		const QList<BMBase*> &elements,
+		bool trimmed = false);
+
 	virtual const QPainterPath &path() const;
 	virtual bool acceptsTrim() const;
 	virtual void applyTrim(const BMTrimPath& trimmer);
@@ -67,9 +90,16 @@ public:
 	int direction() const;
 
 protected:
+	static int PathVertices(const QPainterPath &path);
+	void analyzeGeometry(Complexity &result, int vertices) const;
+
 	QPainterPath m_path;
 	BMTrimPath *m_appliedTrim = nullptr;
 	int m_direction = 0;
+	// Set for the static geometry that may be trimmed, shared with clones.
+	std::shared_ptr<PathLengthCache> m_lengthCache;
+	// Computed by groups with the properties.
+	std::optional<Bounds> m_bounds;
 
 };
 
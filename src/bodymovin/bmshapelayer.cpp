@@ -34,8 +34,16 @@
 #include "bmbasictransform.h"
 #include "bmmasks.h"
 #include "renderer.h"
+#include "complexity.h"
+#include "layercache.h"
 
 namespace Lottie {
+namespace {
+
+// Simpler contents are faster to draw than to sample from a bitmap.
+constexpr auto kMinCachedVertices = 32;
+
+} // namespace
 
 BMShapeLayer::BMShapeLayer(BMBase *parent) : BMLayer(parent) {
 }
@@ -62,6 +70,21 @@ BMShapeLayer::BMShapeLayer(BMBase *parent, const JsonObject &definition)
 			appendChild(shape);
 		}
 	}
+	BMShape::SetupLengthCaches(children());
+
+	// Contents that are never animated look the same in every frame,
+	// up to the layer transform and opacity, so they may be cached.
+	if (!m_effects) {
+		auto contents = Complexity();
+		BMBase::analyze(contents);
+		if (!contents.animatedProperties
+			&& !contents.trimPaths
+			&& (contents.vertices >= kMinCachedVertices
+				|| contents.strokes
+				|| contents.gradients)) {
+			m_contentCache = std::make_shared<LayerCache>();
+		}
+	}
 }
 
 BMShapeLayer::~BMShapeLayer() = default;
@@ -76,6 +99,9 @@ void BMShapeLayer::updateProperties(int frame) {
 	}
 
 	BMLayer::updateProperties(frame);
+	if (m_layerTransform.transparent()) {
+		return;
+	}
 
 	for (BMBase *child : children()) {
 		if (!child->active(frame)) {
@@ -101,9 +127,16 @@ void BMShapeLayer::updateProperties(int frame) {
 			}
 		}
 	}
+	if (m_appliedTrim && !m_appliedTrim->simultaneous()) {
+		m_appliedTrim->trimIndividually(children());
+	}
+	m_contentBounds = BMShape::ContentBounds(children());
 }
 
 void BMShapeLayer::render(Renderer &renderer, int frame) const {
+	if (renderTransparent(renderer)) {
+		return;
+	}
 	renderer.saveState();
 
 	renderEffects(renderer, frame);
@@ -119,17 +152,21 @@ void BMShapeLayer::render(Renderer &renderer, int frame) const {
 		m_masks->render(renderer, frame);
 	}
 
-	for (BMBase *child : children()) {
-		if (child->active(frame)) {
-			child->render(renderer, frame);
-		}
+	if (m_contentBounds && !renderer.visible(m_contentBounds->rect)) {
+		// Nothing to draw in the visible rect.
+	} else if (!m_contentCache || !renderer.renderCached(*this, frame)) {
+		renderContents(renderer, frame);
 	}
 
+	renderer.restoreState();
+}
+
+void BMShapeLayer::renderContents(Renderer &renderer, int frame) const {
+	BMLayer::renderContents(renderer, frame);
+
 	if (m_appliedTrim && m_appliedTrim->active(frame)) {
-		m_appliedTrim->render(renderer, frame);
+		renderer.render(*m_appliedTrim);
 	}
-
-	renderer.restoreState();
 }
 
 } // namespace Lottie
@@ -29,6 +29,7 @@
 #pragma once
 
 #include "bmlayer.h"
+#include "bmshape.h"
 
 namespace Lottie {
 
@@ -45,9 +46,11 @@ public:
 
 	void updateProperties(int frame) override;
 	void render(Renderer &render, int frame) const override;
+	void renderContents(Renderer &renderer, int frame) const override;
 
 private:
 	BMTrimPath *m_appliedTrim = nullptr;
+	std::optional<BMShape::Bounds> m_contentBounds;
 
 };
 
@@ -30,6 +30,7 @@
 
 #include "bmbasictransform.h"
 #include "renderer.h"
+#include "complexity.h"
 
 #include <QtMath>
 
@@ -125,4 +126,10 @@ QTransform BMShapeTransform::apply(QTransform to) const {
 	return to;
 }
 
+void BMShapeTransform::analyze(Complexity &result) const {
+	BMBasicTransform::analyze(result);
+	m_skew.analyze(result);
+	m_skewAxis.analyze(result);
+}
+
 } // namespace Lottie
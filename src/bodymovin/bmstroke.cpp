@@ -29,6 +29,9 @@
 #include "bmstroke.h"
 
 #include "renderer.h"
+#include "complexity.h"
+
+#include <algorithm>
 
 namespace Lottie {
 
@@ -44,7 +47,10 @@ BMStroke::BMStroke(BMBase *parent, const BMStroke &other)
 , m_joinStyle(other.m_joinStyle)
 , m_miterLimit(other.m_miterLimit)
 , m_dashPattern(other.m_dashPattern)
-, m_dashOffset(other.m_dashOffset) {
+, m_dashPatternComputed(other.m_dashPatternComputed)
+, m_dashOffset(other.m_dashOffset)
+, m_pen(other.m_pen)
+, m_animated(other.m_animated) {
 }
 
 BMStroke::BMStroke(BMBase *parent, const JsonObject &definition)
@@ -98,6 +104,17 @@ BMStroke::BMStroke(BMBase *parent, const JsonObject &definition)
 	if (!dash.empty()) {
 		parseDash(dash);
 	}
+
+	m_animated = m_opacity.animated()
+		|| m_width.animated()
+		|| m_color.animated()
+		|| m_dashOffset.animated()
+		|| std::any_of(
+			m_dashPattern.begin(),
+			m_dashPattern.end(),
+			[](const BMProperty<qreal> &part) { return part.animated(); });
+	computeDashPattern();
+	updatePen();
 }
 
 void BMStroke::parseDash(const JsonArray &definition) {
@@ -124,18 +141,27 @@ BMBase *BMStroke::clone(BMBase *parent) const {
 }
 
 void BMStroke::updateProperties(int frame) {
+	if (!m_animated) {
+		return;
+	}
 	m_opacity.update(frame);
 	m_width.update(frame);
 	m_color.update(frame);
 	m_dashOffset.update(frame);
+	for (auto &part : m_dashPattern) {
+		part.update(frame);
+	}
+	computeDashPattern();
+	updatePen();
+}
 
+void BMStroke::computeDashPattern() {
 	const auto width = m_width.value();
 	const auto count = m_dashPattern.size();
 	const auto twice = (count % 2 != 0);
 	m_dashPatternComputed.resize(twice ? (2 * count) : count);
 	auto i = 0;
-	for (auto &part : m_dashPattern) {
-		part.update(frame);
+	for (const auto &part : m_dashPattern) {
 		m_dashPatternComputed[i++] = part.value() / width;
 	}
 	if (twice) {
@@ -149,10 +175,32 @@ void BMStroke::render(Renderer &renderer, int frame) const {
 	renderer.render(*this);
 }
 
-QPen BMStroke::pen() const {
+const QPen &BMStroke::pen() const {
+	return m_pen;
+}
+
+qreal BMStroke::extent() const {
+	return Extent(m_pen);
+}
+
+qreal BMStroke::Extent(const QPen &pen) {
+	if (pen.style() == Qt::NoPen) {
+		return 0.;
+	}
+	// Miter joins may stick out up to the miter limit times half width.
+	const auto width = std::max(pen.widthF(), 1.);
+	const auto join = (pen.joinStyle() == Qt::MiterJoin)
+		? std::max(pen.miterLimit(), 1.)
+		: 1.;
+	return width * join / 2.
+		+ ((pen.capStyle() == Qt::SquareCap) ? width : 0.);
+}
+
+void BMStroke::updatePen() {
 	const auto width = m_width.value();
 	if (qFuzzyIsNull(width)) {
-		return QPen(Qt::NoPen);
+		m_pen = QPen(Qt::NoPen);
+		return;
 	}
 	QPen pen;
 	QColor color(getColor());
@@ -166,7 +214,7 @@ QPen BMStroke::pen() const {
 		pen.setDashPattern(m_dashPatternComputed);
 		pen.setDashOffset(m_dashOffset.value() / width);
 	}
-	return pen;
+	m_pen = std::move(pen);
 }
 
 QColor BMStroke::getColor() const {
@@ -177,4 +225,16 @@ qreal BMStroke::opacity() const {
 	return m_opacity.value();
 }
 
+void BMStroke::analyze(Complexity &result) const {
+	++result.paints;
+	++result.strokes;
+	m_opacity.analyze(result);
+	m_width.analyze(result);
+	m_color.analyze(result);
+	for (const auto &dash : m_dashPattern) {
+		dash.analyze(result);
+	}
+	m_dashOffset.analyze(result);
+}
+
 } // namespace Lottie
@@ -45,15 +45,24 @@ public:
 
 	void updateProperties(int frame) override;
 	void render(Renderer &renderer, int frame) const override;
+	void analyze(Complexity &result) const override;
 
-	QPen pen() const;
+	const QPen &pen() const;
 	qreal opacity() const;
 
+	// How far the stroke may reach out of the stroked path.
+	qreal extent() const;
+
+	// Same for any pen, in its units, zero width pens are one pixel wide.
+	static qreal Extent(const QPen &pen);
+
 protected:
 	QColor getColor() const;
 
 protected:
 	void parseDash(const JsonArray &definition);
+	void computeDashPattern();
+	void updatePen();
 
 	BMProperty<qreal> m_opacity;
 	BMProperty<qreal> m_width;
@@ -64,6 +73,9 @@ protected:
 	QVector<BMProperty<qreal>> m_dashPattern;
 	QVector<qreal> m_dashPatternComputed;
 	BMProperty<qreal> m_dashOffset;
+	// Resolved once for static strokes and shared with the clones.
+	QPen m_pen;
+	bool m_animated = false;
 
 };
 
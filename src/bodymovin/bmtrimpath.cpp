@@ -29,7 +29,9 @@
 #include "bmtrimpath.h"
 
 #include "trimpath.h"
+#include "pathaccumulator.h"
 #include "renderer.h"
+#include "complexity.h"
 
 #include <QtGlobal>
 #include <private/qpainterpath_p.h>
@@ -106,7 +108,7 @@ void BMTrimPath::render(Renderer &renderer, int frame) const {
 		renderer.setTrimmingState(Renderer::Off);
 	}
 
-	renderer.render(*this);
+	// The trimmed shapes are drawn by the owner after its contents.
 }
 
 bool BMTrimPath::acceptsTrim() const {
@@ -140,9 +142,10 @@ bool BMTrimPath::simultaneous() const {
 	return m_simultaneous;
 }
 
-QPainterPath BMTrimPath::trim(const QPainterPath &path) const {
-	TrimPath trimmer;
-	trimmer.setPath(path);
+QPainterPath BMTrimPath::trim(
+		const QPainterPath &path,
+		PathLengthCache *lengths) const {
+	const auto trimmer = lengths ? lengths->trimmer(path) : TrimPath(path);
 	qreal offset = m_offset.value() / 360.0;
 	qreal start = m_start.value() / 100.0;
 	qreal end = m_end.value() / 100.0;
@@ -153,4 +156,35 @@ QPainterPath BMTrimPath::trim(const QPainterPath &path) const {
 	return trimmedPath;
 }
 
+void BMTrimPath::trimIndividually(const QList<BMBase*> &shapes) {
+	// Shapes are kept in the reverse order, the path follows the original.
+	auto united = PathAccumulator();
+	for (auto i = shapes.size(); i != 0;) {
+		const auto shape = dynamic_cast<BMShape*>(shapes[--i]);
+		if (!shape
+			|| shape->hidden()
+			|| !shape->acceptsTrim()
+			|| shape->type() == BM_SHAPE_GROUP_IX
+			|| shape->type() == BM_SHAPE_TRIM_IX) {
+			continue;
+		}
+		united.add(shape->path());
+	}
+	const auto path = united.result();
+	m_individualPath = qFuzzyIsNull(path.length())
+		? QPainterPath()
+		: trim(path);
+}
+
+const QPainterPath &BMTrimPath::individualPath() const {
+	return m_individualPath;
+}
+
+void BMTrimPath::analyze(Complexity &result) const {
+	++result.trimPaths;
+	m_start.analyze(result);
+	m_end.analyze(result);
+	m_offset.analyze(result);
+}
+
 } // namespace Lottie
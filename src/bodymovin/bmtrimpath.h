@@ -33,6 +33,8 @@
 
 namespace Lottie {
 
+class PathLengthCache;
+
 class BMTrimPath : public BMShape {
 public:
 	BMTrimPath(BMBase *parent);
@@ -47,6 +49,7 @@ public:
 
 	void updateProperties(int frame) override;
 	void render(Renderer &renderer, int frame) const override;
+	void analyze(Complexity &result) const override;
 
 	bool acceptsTrim() const override;
 	void applyTrim(const BMTrimPath  &trimmer) override;
@@ -56,13 +59,21 @@ public:
 	qreal offset() const;
 	bool simultaneous() const;
 
-	QPainterPath trim(const QPainterPath &path) const;
+	QPainterPath trim(
+		const QPainterPath &path,
+		PathLengthCache *lengths = nullptr) const;
+
+	// In the individual mode the shapes are trimmed as one path, which
+	// is computed here with the properties and only drawn by renderers.
+	void trimIndividually(const QList<BMBase*> &shapes);
+	const QPainterPath &individualPath() const;
 
 protected:
 	BMProperty<qreal> m_start;
 	BMProperty<qreal> m_end;
 	BMProperty<qreal> m_offset;
 	bool m_simultaneous = false;
+	QPainterPath m_individualPath;
 
 };
 
@@ -0,0 +1,154 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "complexity.h"
+
+#include <QDebug>
+#include <algorithm>
+#include <limits>
+
+namespace Lottie {
+namespace {
+
+// Relative weights of the elements, see estimatedFrameCost().
+
+// Evaluation: cloning and updating the tree, building paths.
+constexpr auto kLayerCost = 3.;
+constexpr auto kShapeCost = 1.;
+constexpr auto kAnimatedPropertyCost = 0.3;
+constexpr auto kVertexCost = 0.05;
+
+// Rasterization.
+constexpr auto kPaintCost = 10.;
+constexpr auto kStrokeCost = 15.;
+constexpr auto kGradientCost = 5.;
+constexpr auto kMaskCost = 20.;
+constexpr auto kMatteCost = 30.;
+constexpr auto kTrimPathCost = 8.;
+constexpr auto kVertexRasterCost = 0.1;
+
+thread_local BudgetTracker *CurrentTracker = nullptr;
+
+[[nodiscard]] int Append(int value, int other, int times) {
+	return Saturate(value + qint64(other) * times);
+}
+
+} // namespace
+
+int Saturate(qint64 value) {
+	return int(std::clamp(
+		value,
+		qint64(std::numeric_limits<int>::min()),
+		qint64(std::numeric_limits<int>::max())));
+}
+
+void Complexity::append(const Complexity &other, int times) {
+	layers = Append(layers, other.layers, 1);
+	shapes = Append(shapes, other.shapes, times);
+	vertices = Append(vertices, other.vertices, times);
+	maxPathVertices = std::max(maxPathVertices, other.maxPathVertices);
+	paints = Append(paints, other.paints, times);
+	strokes = Append(strokes, other.strokes, times);
+	gradients = Append(gradients, other.gradients, times);
+	animatedProperties = Append(
+		animatedProperties,
+		other.animatedProperties,
+		1);
+	maxKeyframes = std::max(maxKeyframes, other.maxKeyframes);
+	repeaterCopies = Append(repeaterCopies, other.repeaterCopies, times);
+	masks = Append(masks, other.masks, times);
+	mattes = Append(mattes, other.mattes, times);
+	trimPaths = Append(trimPaths, other.trimPaths, times);
+	precompDepth = std::max(precompDepth, other.precompDepth);
+}
+
+double Complexity::estimatedFrameCost() const {
+	const auto evaluation = layers * kLayerCost
+		+ shapes * kShapeCost
+		+ animatedProperties * kAnimatedPropertyCost
+		+ vertices * kVertexCost;
+	const auto rasterization = paints * kPaintCost
+		+ strokes * kStrokeCost
+		+ gradients * kGradientCost
+		+ masks * kMaskCost
+		+ mattes * kMatteCost
+		+ trimPaths * kTrimPathCost
+		+ vertices * kVertexRasterCost;
+	return evaluation + rasterization;
+}
+
+BudgetTracker::Scope::Scope(BudgetTracker *tracker)
+: _previous(CurrentTracker) {
+	CurrentTracker = tracker;
+}
+
+BudgetTracker::Scope::~Scope() {
+	CurrentTracker = _previous;
+}
+
+BudgetTracker::BudgetTracker(const Budget &budget) : _budget(budget) {
+}
+
+BudgetTracker *BudgetTracker::Current() {
+	return CurrentTracker;
+}
+
+const Budget &BudgetTracker::budget() const {
+	return _budget;
+}
+
+bool BudgetTracker::exceeded() const {
+	return _exceeded;
+}
+
+bool BudgetTracker::addNode() {
+	const auto nodes = ++_nodes;
+	if (nodes > _budget.maxNodes) {
+		reject("nodes", nodes);
+		return false;
+	}
+	return true;
+}
+
+bool BudgetTracker::check(const Complexity &element) {
+	if (element.maxPathVertices > _budget.maxPathVertices) {
+		reject("path vertices", element.maxPathVertices);
+		return false;
+	} else if (element.maxKeyframes > _budget.maxKeyframes) {
+		reject("keyframes", element.maxKeyframes);
+		return false;
+	} else if (element.repeaterCopies > _budget.maxRepeaterCopies) {
+		reject("repeater copies", element.repeaterCopies);
+		return false;
+	}
+	return true;
+}
+
+bool BudgetTracker::checkPrecompDepth(int depth) {
+	if (depth > _budget.maxPrecompDepth) {
+		reject("precomp depth", depth);
+		return false;
+	}
+	return true;
+}
+
+bool BudgetTracker::checkInstantiatedNodes(qint64 nodes) {
+	if (nodes > _budget.maxNodes) {
+		reject("instantiated nodes", nodes);
+		return false;
+	}
+	return true;
+}
+
+void BudgetTracker::reject(const char *reason, qint64 value) {
+	// Warn only once, all the following violations are rejected silently.
+	if (!_exceeded.exchange(true)) {
+		qWarning() << "Lottie: Budget exceeded," << reason << value;
+	}
+}
+
+} // namespace Lottie
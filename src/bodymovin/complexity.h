@@ -0,0 +1,93 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include <QtGlobal>
+#include <atomic>
+
+namespace Lottie {
+
+// Clamps a wide intermediate, so that counters saturate on hostile inputs.
+[[nodiscard]] int Saturate(qint64 value);
+
+struct Complexity {
+	int layers = 0;
+	int shapes = 0;
+	int vertices = 0;
+	int maxPathVertices = 0;
+	int paints = 0;
+	int strokes = 0;
+	int gradients = 0;
+	int animatedProperties = 0;
+	int maxKeyframes = 0;
+	int repeaterCopies = 0;
+	int masks = 0;
+	int mattes = 0;
+	int trimPaths = 0;
+	int precompDepth = 0;
+
+	// Drawing related counters are multiplied by times (repeater copies),
+	// evaluation related ones are added once.
+	void append(const Complexity &other, int times = 1);
+
+	// Relative per-frame cost in arbitrary units, only for comparing the
+	// compositions with each other. The weights are not calibrated, so it
+	// doesn't predict the rendering time.
+	[[nodiscard]] double estimatedFrameCost() const;
+};
+
+struct Budget {
+	int maxNodes = 100000;
+	int maxPathVertices = 10000;
+	int maxRepeaterCopies = 1000;
+	int maxPrecompDepth = 16;
+	int maxKeyframes = 5000;
+};
+
+// Counts the elements constructed for one scene against its budget.
+class BudgetTracker final {
+public:
+	// Makes the tracker current for the parsing done on this thread.
+	class Scope final {
+	public:
+		explicit Scope(BudgetTracker *tracker);
+		Scope(const Scope &other) = delete;
+		Scope &operator=(const Scope &other) = delete;
+		~Scope();
+
+	private:
+		BudgetTracker *_previous = nullptr;
+
+	};
+
+	explicit BudgetTracker(const Budget &budget);
+
+	[[nodiscard]] static BudgetTracker *Current();
+
+	[[nodiscard]] const Budget &budget() const;
+	[[nodiscard]] bool exceeded() const;
+
+	// Each returns false and marks the budget exceeded on failure.
+	[[nodiscard]] bool addNode();
+	bool check(const Complexity &element);
+	bool checkPrecompDepth(int depth);
+
+	// Nodes of the whole composition with each precomp counted once per
+	// instance, found before the precomp assets are constructed.
+	bool checkInstantiatedNodes(qint64 nodes);
+
+private:
+	void reject(const char *reason, qint64 value);
+
+	const Budget _budget;
+	std::atomic<int> _nodes = 0;
+	std::atomic<bool> _exceeded = false;
+
+};
+
+} // namespace Lottie
@@ -28,15 +28,62 @@
 ****************************************************************************/
 #include "bmfreeformshape.h"
 
+#include "trackcache.h"
+
 #include <QPainterPath>
 
 namespace Lottie {
+namespace {
+
+[[nodiscard]] quint64 HashPath(const QPainterPath &path) {
+	auto result = TrackHash();
+	result.add('P');
+	for (auto i = 0, count = path.elementCount(); i != count; ++i) {
+		const auto element = path.elementAt(i);
+		result.add(int(element.type));
+		result.add(element.x);
+		result.add(element.y);
+	}
+	return result.value();
+}
+
+// QPainterPath::operator==() compares the coordinates fuzzily.
+[[nodiscard]] bool SamePath(const QPainterPath &a, const QPainterPath &b) {
+	const auto count = a.elementCount();
+	if (b.elementCount() != count || a.fillRule() != b.fillRule()) {
+		return false;
+	}
+	for (auto i = 0; i != count; ++i) {
+		const auto first = a.elementAt(i);
+		const auto second = b.elementAt(i);
+		if (first.type != second.type
+			|| first.x != second.x
+			|| first.y != second.y) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Static shapes copied across layers end up sharing one path data.
+[[nodiscard]] QPainterPath DeduplicatedPath(QPainterPath &&path) {
+	const auto hash = HashPath(path);
+	return Deduplicated<QPainterPath>(hash, [&] {
+		return std::move(path);
+	}, [](const QPainterPath &a, const QPainterPath &b) {
+		return SamePath(a, b);
+	}, [](const QPainterPath &path) {
+		return qint64(path.elementCount()) * sizeof(QPainterPath::Element);
+	});
+}
+
+} // namespace
 
 QPainterPath FreeFormShape::parse(const JsonObject &definition) {
 	const auto value = definition.value("k");
 	const auto animated = value.isArray();
 	if (!animated) {
-		return buildShape(value.toObject());
+		return DeduplicatedPath(buildShape(value.toObject()));
 	}
 	parseShapeKeyframes(value.toArray());
 	return QPainterPath();
@@ -257,4 +304,16 @@ QPainterPath FreeFormShape::buildShape(int frame) {
 	return result;
 }
 
+int FreeFormShape::vertexCount() const {
+	return m_vertexList.size();
+}
+
+void FreeFormShape::analyze(Complexity &result) const {
+	for (const auto &info : m_vertexList) {
+		info.pos.analyze(result);
+		info.ci.analyze(result);
+		info.co.analyze(result);
+	}
+}
+
 } // namespace Lottie
@@ -42,6 +42,9 @@ public:
 	QPainterPath parse(const JsonObject &definition);
 	QPainterPath build(int frame);
 
+	int vertexCount() const;
+	void analyze(Complexity &result) const;
+
 private:
 	struct VertexInfo {
 		BMProperty<QPointF> pos;
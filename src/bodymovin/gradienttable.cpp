@@ -0,0 +1,63 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "gradienttable.h"
+
+#include <QColor>
+
+#include <cmath>
+
+namespace Lottie {
+namespace {
+
+[[nodiscard]] uint32_t InterpolatePixel(uint32_t a, uint32_t b, double t) {
+	auto result = uint32_t();
+	for (auto shift = 0; shift != 32; shift += 8) {
+		const auto from = double((a >> shift) & 0xFFU);
+		const auto till = double((b >> shift) & 0xFFU);
+		result |= uint32_t(std::lround(from + (till - from) * t)) << shift;
+	}
+	return result;
+}
+
+} // namespace
+
+// Colors are interpolated premultiplied, the same way QPainter does.
+GradientTable BuildGradientTable(const QGradientStops &stops) {
+	auto result = GradientTable();
+	if (stops.isEmpty()) {
+		result.fill(0);
+		return result;
+	}
+	const auto premultiplied = [&](int index) {
+		return uint32_t(qPremultiply(stops[index].second.rgba()));
+	};
+	auto stop = 0;
+	for (auto i = 0; i != kGradientTableSize; ++i) {
+		const auto t = double(i) / (kGradientTableSize - 1);
+		while (stop < stops.size() && stops[stop].first < t) {
+			++stop;
+		}
+		if (stop == 0) {
+			result[i] = premultiplied(0);
+		} else if (stop == stops.size()) {
+			result[i] = premultiplied(stop - 1);
+		} else {
+			const auto from = stops[stop - 1].first;
+			const auto till = stops[stop].first;
+			result[i] = (till > from)
+				? InterpolatePixel(
+					premultiplied(stop - 1),
+					premultiplied(stop),
+					(t - from) / (till - from))
+				: premultiplied(stop);
+		}
+	}
+	return result;
+}
+
+} // namespace Lottie
@@ -0,0 +1,24 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include <QGradient>
+
+#include <array>
+#include <cstdint>
+
+namespace Lottie {
+
+constexpr auto kGradientTableSize = 256;
+
+// Premultiplied ARGB32 colors of a gradient, evenly spaced from 0 to 1.
+using GradientTable = std::array<uint32_t, kGradientTableSize>;
+
+[[nodiscard]] GradientTable BuildGradientTable(const QGradientStops &stops);
+
+} // namespace Lottie
@@ -9,6 +9,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include <QByteArray>
 #include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
 
 namespace Lottie {
 namespace details {
@@ -145,6 +147,10 @@ public:
 		return find(key) != end();
 	}
 
+	// In-situ parsing invalidates the source range, so a subtree that
+	// should outlive its document is kept as a compact re-serialization.
+	QByteArray serialize() const;
+
 private:
 	const rapidjson::Document::ValueType *_value = nullptr;
 
@@ -296,4 +302,11 @@ inline QByteArray JsonValue::toString() const {
 		: QByteArray();
 }
 
+inline QByteArray JsonObject::serialize() const {
+	rapidjson::StringBuffer buffer;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+	_value->Accept(writer);
+	return QByteArray(buffer.GetString(), int(buffer.GetSize()));
+}
+
 } // namespace Lottie
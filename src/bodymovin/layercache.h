@@ -0,0 +1,48 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include <QImage>
+#include <QRectF>
+#include <QMutex>
+
+#include <array>
+
+namespace Lottie {
+
+struct LayerCacheImage {
+	QImage image;
+
+	// Where the image is drawn in the layer coordinates.
+	QRectF rect;
+
+	// Device pixels per layer unit the image was rasterized for, zero
+	// while there is no image.
+	qreal scale = 0.;
+};
+
+// Contents of a layer which change only by the layer transform and
+// opacity, rasterized once by the renderer and shared between the layer
+// and all its per-frame clones. The image is used only while the layer is
+// drawn fully opaque, so that it matches the vector contents exactly.
+struct LayerCache {
+	QMutex mutex;
+
+	// Two scales, so that targets of different sizes drawn in turn, like
+	// a thumbnail and the full size frame, don't rebuild each other.
+	std::array<LayerCacheImage, 2> images;
+	int lastUsed = 0;
+
+	// Builds since the scale was last stable, vectors are drawn when
+	// there are too many of them.
+	int builds = 0;
+	qreal lastScale = 0.;
+	int stableRenders = 0;
+};
+
+} // namespace Lottie
@@ -0,0 +1,85 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "parallel.h"
+
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <atomic>
+
+namespace Lottie {
+namespace {
+
+class Worker final : public QRunnable {
+public:
+	Worker(
+		int count,
+		std::atomic<int> &next,
+		QSemaphore &finished,
+		const std::function<void(int)> &method);
+
+	void run() override;
+
+private:
+	const int _count = 0;
+	std::atomic<int> &_next;
+	QSemaphore &_finished;
+	const std::function<void(int)> &_method;
+
+};
+
+Worker::Worker(
+	int count,
+	std::atomic<int> &next,
+	QSemaphore &finished,
+	const std::function<void(int)> &method)
+: _count(count)
+, _next(next)
+, _finished(finished)
+, _method(method) {
+	setAutoDelete(true);
+}
+
+void Worker::run() {
+	for (auto i = _next++; i < _count; i = _next++) {
+		_method(i);
+	}
+	_finished.release();
+}
+
+} // namespace
+
+void ParallelFor(int count, const std::function<void(int)> &method) {
+	if (count < 2) {
+		if (count > 0) {
+			method(0);
+		}
+		return;
+	}
+	std::atomic<int> next{ 0 };
+	QSemaphore finished;
+	auto started = 0;
+
+	// tryStart never queues, so nested or concurrent calls on a busy pool
+	// simply run on fewer threads instead of waiting for each other.
+	const auto pool = QThreadPool::globalInstance();
+	while (started + 1 < count) {
+		const auto worker = new Worker(count, next, finished, method);
+		if (!pool->tryStart(worker)) {
+			delete worker;
+			break;
+		}
+		++started;
+	}
+	for (auto i = next++; i < count; i = next++) {
+		method(i);
+	}
+	finished.acquire(started);
+}
+
+} // namespace Lottie
@@ -0,0 +1,19 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include <functional>
+
+namespace Lottie {
+
+// Calls method(index) for every index in [0, count) using the threads
+// of the global QThreadPool that are free right now, the calling thread
+// takes part as well. Returns when all the calls have finished.
+void ParallelFor(int count, const std::function<void(int)> &method);
+
+} // namespace Lottie
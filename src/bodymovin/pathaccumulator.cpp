@@ -0,0 +1,47 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "pathaccumulator.h"
+
+namespace Lottie {
+
+void PathAccumulator::add(const QPainterPath &path) {
+	if (!path.isEmpty()) {
+		_paths.push_back(path);
+		_elements += path.elementCount();
+	}
+}
+
+void PathAccumulator::clear() {
+	_paths.clear();
+	_elements = 0;
+}
+
+bool PathAccumulator::empty() const {
+	return _paths.empty();
+}
+
+QPainterPath PathAccumulator::result(Order order) const {
+	if (_paths.empty()) {
+		return QPainterPath();
+	} else if (_paths.size() == 1) {
+		return _paths.front();
+	}
+	const auto reversed = (order == Order::Reversed);
+	auto result = QPainterPath();
+	result.reserve(_elements);
+	result.setFillRule(reversed
+		? _paths.back().fillRule()
+		: _paths.front().fillRule());
+	const auto count = int(_paths.size());
+	for (auto i = 0; i != count; ++i) {
+		result.addPath(_paths[reversed ? (count - i - 1) : i]);
+	}
+	return result;
+}
+
+} // namespace Lottie
@@ -0,0 +1,41 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include <QPainterPath>
+
+#include <vector>
+
+namespace Lottie {
+
+// Collects paths to be drawn as one. Adding only keeps a shared copy,
+// the result is built once with a single allocation, so collecting
+// many shapes takes linear time instead of copying the whole path on
+// every addition.
+class PathAccumulator final {
+public:
+	enum class Order {
+		Added,
+		Reversed,
+	};
+
+	void add(const QPainterPath &path);
+	void clear();
+
+	[[nodiscard]] bool empty() const;
+
+	// The fill rule is taken from the first path of the result.
+	[[nodiscard]] QPainterPath result(Order order = Order::Added) const;
+
+private:
+	std::vector<QPainterPath> _paths;
+	int _elements = 0;
+
+};
+
+} // namespace Lottie
@@ -38,6 +38,14 @@ Renderer::TrimmingState Renderer::trimmingState() const {
 	return m_trimmingState;
 }
 
+bool Renderer::renderCached(const BMLayer &layer, int frame) {
+	return false;
+}
+
+bool Renderer::visible(const QRectF &rect) const {
+	return true;
+}
+
 void Renderer::saveTrimmingState() {
 	m_trimStateStack.push(m_trimmingState);
 }
@@ -30,6 +30,8 @@
 
 #include <QStack>
 
+class QRectF;
+
 namespace Lottie {
 
 class BMBase;
@@ -85,6 +87,14 @@ public:
 	virtual void render(const BMMaskShape &shape) = 0;
 	virtual void render(const BMMasks &masks) = 0;
 
+	// Draws the layer contents from its cache if it has one,
+	// returns false if they should be rendered as usual.
+	virtual bool renderCached(const BMLayer &layer, int frame);
+
+	// Returns false if nothing drawn inside the rect in the current
+	// coordinates can be seen, so that it is skipped.
+	virtual bool visible(const QRectF &rect) const;
+
 protected:
 	void saveTrimmingState();
 	void restoreTrimmingState();
@@ -0,0 +1,81 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "trackcache.h"
+
+#include <QMutexLocker>
+
+namespace Lottie {
+namespace {
+
+thread_local TrackCache *CurrentCache = nullptr;
+
+// The hash node, the key and the shared pointer control block.
+constexpr auto kEntryOverhead = qint64(4 * sizeof(void*) + sizeof(quint64));
+
+} // namespace
+
+void TrackHash::addBytes(const void *data, std::size_t size) {
+	const auto bytes = static_cast<const uchar*>(data);
+	for (auto i = std::size_t(); i != size; ++i) {
+		_value = (_value ^ bytes[i]) * 1099511628211ULL;
+	}
+}
+
+quint64 TrackHash::value() const {
+	return _value;
+}
+
+TrackCache::Scope::Scope(TrackCache *cache) : _previous(CurrentCache) {
+	CurrentCache = cache;
+}
+
+TrackCache::Scope::~Scope() {
+	CurrentCache = _previous;
+}
+
+TrackCache *TrackCache::Current() {
+	return CurrentCache;
+}
+
+std::shared_ptr<const void> TrackCache::find(
+		quint64 hash,
+		const std::function<bool(const void*)> &equal) {
+	QMutexLocker lock(&_mutex);
+	for (auto i = _entries.constFind(hash); i != _entries.constEnd(); ++i) {
+		if (i.key() != hash) {
+			break;
+		} else if (equal(i->value.get())) {
+			_savedBytes += i->bytes;
+			++_sharedCount;
+			return i->value;
+		}
+	}
+	return nullptr;
+}
+
+void TrackCache::insert(
+		quint64 hash,
+		std::shared_ptr<const void> value,
+		qint64 bytes,
+		qint64 overhead) {
+	QMutexLocker lock(&_mutex);
+	_entries.insert(hash, { std::move(value), bytes });
+	_overheadBytes += overhead + qint64(sizeof(Entry)) + kEntryOverhead;
+}
+
+qint64 TrackCache::savedBytes() const {
+	QMutexLocker lock(&_mutex);
+	return _savedBytes - _overheadBytes;
+}
+
+int TrackCache::sharedCount() const {
+	QMutexLocker lock(&_mutex);
+	return _sharedCount;
+}
+
+} // namespace Lottie
@@ -0,0 +1,110 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <functional>
+#include <memory>
+#include <type_traits>
+
+namespace Lottie {
+
+// 64-bit FNV-1a of raw value bytes, it only selects the stored values
+// which are then compared with the new one.
+class TrackHash final {
+public:
+	template <typename T>
+	void add(const T &value) {
+		static_assert(std::is_arithmetic_v<T>);
+		addBytes(&value, sizeof(value));
+	}
+	void addBytes(const void *data, std::size_t size);
+
+	[[nodiscard]] quint64 value() const;
+
+private:
+	quint64 _value = 14695981039346656037ULL;
+
+};
+
+// Shares identical immutable data (keyframe tracks, static paths) between
+// all the elements of one scene that were parsed from equal JSON values.
+class TrackCache final {
+public:
+	// Makes the cache current for the parsing done on this thread.
+	class Scope final {
+	public:
+		explicit Scope(TrackCache *cache);
+		Scope(const Scope &other) = delete;
+		Scope &operator=(const Scope &other) = delete;
+		~Scope();
+
+	private:
+		TrackCache *_previous = nullptr;
+
+	};
+
+	[[nodiscard]] static TrackCache *Current();
+
+	[[nodiscard]] std::shared_ptr<const void> find(
+		quint64 hash,
+		const std::function<bool(const void*)> &equal);
+	void insert(
+		quint64 hash,
+		std::shared_ptr<const void> value,
+		qint64 bytes,
+		qint64 overhead);
+
+	// Memory that was not allocated because an equal value was shared,
+	// minus the memory taken by the cache itself, may be negative.
+	[[nodiscard]] qint64 savedBytes() const;
+	[[nodiscard]] int sharedCount() const;
+
+private:
+	struct Entry {
+		std::shared_ptr<const void> value;
+		qint64 bytes = 0;
+	};
+
+	mutable QMutex _mutex;
+	QMultiHash<quint64, Entry> _entries;
+	qint64 _savedBytes = 0;
+	qint64 _overheadBytes = 0;
+	int _sharedCount = 0;
+
+};
+
+// Returns the shared copy of an equal value in the current cache, storing
+// the newly built one if there is none.
+template <typename Value, typename Build, typename Equal, typename Bytes>
+[[nodiscard]] Value Deduplicated(
+		quint64 hash,
+		Build &&build,
+		Equal &&equal,
+		Bytes &&bytes) {
+	auto result = build();
+	const auto cache = TrackCache::Current();
+	if (!cache) {
+		return result;
+	}
+	const auto found = cache->find(hash, [&](const void *stored) {
+		return equal(*static_cast<const Value*>(stored), result);
+	});
+	if (found) {
+		return *static_cast<const Value*>(found.get());
+	}
+	cache->insert(
+		hash,
+		std::make_shared<Value>(result),
+		bytes(result),
+		qint64(sizeof(Value)));
+	return result;
+}
+
+} // namespace Lottie
@@ -28,6 +28,8 @@
 ****************************************************************************/
 #include "trimpath.h"
 
+#include "bezierlength.h"
+
 #include <private/qpainterpath_p.h>
 #include <private/qbezier_p.h>
 #include <QtMath>
@@ -116,6 +118,15 @@ QPainterPath TrimPath::trimmed(qreal f1, qreal f2, qreal offset) const {
 	return res;
 }
 
+TrimPath PathLengthCache::trimmer(const QPainterPath &path) {
+	std::call_once(_measured, [&] {
+		_lengths = TrimPath(path).lengths();
+	});
+	return (_lengths.size() == path.elementCount())
+		? TrimPath(path, _lengths)
+		: TrimPath(path);
+}
+
 void TrimPath::updateLens() const {
 	const int numElems = mPath.elementCount();
 	mLens.resize(numElems);
@@ -135,7 +146,7 @@ void TrimPath::updateLens() const {
 		case QPainterPath::CurveToElement: {
 			Q_ASSERT(i < numElems - 2);
 			QPainterPath::Element ee = mPath.elementAt(i + 2);
-			runLen += QBezier::fromPoints(runPt, e, mPath.elementAt(i + 1), ee).length();
+			runLen += BezierLength(QBezier::fromPoints(runPt, e, mPath.elementAt(i + 1), ee)).length();
 			runPt = ee;
 			break;
 		}
@@ -192,8 +203,9 @@ void TrimPath::appendTrimmedElement(QPainterPath * to, int elemIdx, bool trimSta
 		Q_ASSERT(elemIdx < mPath.elementCount() - 2);
 
 		QBezier b = QBezier::fromPoints(pp, e, mPath.elementAt(elemIdx + 1), mPath.elementAt(elemIdx + 2));
-		qreal t1 = trimStart ? b.tAtLength(len1) : 0.0;  // or simply len1/elemLen to trim by t instead of len
-		qreal t2 = trimEnd ? b.tAtLength(len2) : 1.0;
+		BezierLength lengths(b);
+		qreal t1 = trimStart ? lengths.tAtLength(len1) : 0.0;  // or simply len1/elemLen to trim by t instead of len
+		qreal t2 = trimEnd ? lengths.tAtLength(len2) : 1.0;
 		QBezier c = b.getSubRange(t1, t2);
 		if (to->isEmpty()) {
 			to->moveTo(c.pt1());
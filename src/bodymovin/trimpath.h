@@ -30,6 +30,8 @@
 
 #include <QPainterPath>
 
+#include <mutex>
+
 namespace Lottie {
 
 class TrimPath {
@@ -37,6 +39,8 @@ public:
 	TrimPath() = default;
 	TrimPath(const QPainterPath &path)
 		: mPath(path) {}
+	TrimPath(const QPainterPath &path, const QVector<qreal> &lens)
+		: mPath(path), mLens(lens) {}
 	TrimPath(const TrimPath &other)
 		: mPath(other.mPath), mLens(other.mLens) {}
 	~TrimPath() {}
@@ -52,6 +56,14 @@ public:
 
 	QPainterPath trimmed(qreal f1, qreal f2, qreal offset = 0.0) const;
 
+	// Cumulative lengths at the ends of the path elements.
+	const QVector<qreal> &lengths() const {
+		if (lensIsDirty()) {
+			updateLens();
+		}
+		return mLens;
+	}
+
 private:
 	bool lensIsDirty() const {
 		return mLens.size() != mPath.elementCount();
@@ -74,4 +86,17 @@ private:
 
 };
 
+// Element lengths of a static path, measured on its first trim, so that
+// animated trims don't measure its curves again every frame. Shared
+// between the clones of a shape.
+class PathLengthCache final {
+public:
+	[[nodiscard]] TrimPath trimmer(const QPainterPath &path);
+
+private:
+	std::once_flag _measured;
+	QVector<qreal> _lengths;
+
+};
+
 } // namespace Lottie
@@ -0,0 +1,438 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "blendspans.h"
+
+#include <cstring>
+
+#if defined(__AVX2__)
+#define LOTTIE_SPANS_AVX2
+#include <immintrin.h>
+#endif // __AVX2__
+
+#if defined(__SSE2__) \
+	|| defined(_M_X64) \
+	|| (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LOTTIE_SPANS_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define LOTTIE_SPANS_NEON
+#include <arm_neon.h>
+#endif // __SSE2__ || __ARM_NEON
+
+namespace Lottie {
+namespace {
+
+[[nodiscard]] inline uint32_t LoadCoverage4(const uint8_t *coverage) {
+	auto result = uint32_t();
+	memcpy(&result, coverage, sizeof(result));
+	return result;
+}
+
+#ifdef LOTTIE_SPANS_SSE2
+
+[[nodiscard]] inline __m128i Div255x8(__m128i value) {
+	const auto rounded = _mm_add_epi16(value, _mm_set1_epi16(128));
+	return _mm_srli_epi16(
+		_mm_add_epi16(rounded, _mm_srli_epi16(rounded, 8)),
+		8);
+}
+
+// Repeats each of the four coverage bytes four times.
+[[nodiscard]] inline __m128i ExpandCoverage4(uint32_t coverage) {
+	auto result = _mm_cvtsi32_si128(int(coverage));
+	result = _mm_unpacklo_epi8(result, result);
+	return _mm_unpacklo_epi16(result, result);
+}
+
+[[nodiscard]] inline __m128i BroadcastAlpha2(__m128i pixels) {
+	const auto low = _mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3));
+	return _mm_shufflehi_epi16(low, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+// Two pixels unpacked to 16 bit channels.
+[[nodiscard]] inline __m128i Blend2(__m128i dst, __m128i src, __m128i cov) {
+	const auto scaled = Div255x8(_mm_mullo_epi16(src, cov));
+	const auto inverted = _mm_sub_epi16(
+		_mm_set1_epi16(255),
+		BroadcastAlpha2(scaled));
+	return _mm_add_epi16(
+		scaled,
+		Div255x8(_mm_mullo_epi16(dst, inverted)));
+}
+
+[[nodiscard]] inline __m128i Blend4(__m128i dst, __m128i src, __m128i cov) {
+	const auto zero = _mm_setzero_si128();
+	const auto low = Blend2(
+		_mm_unpacklo_epi8(dst, zero),
+		_mm_unpacklo_epi8(src, zero),
+		_mm_unpacklo_epi8(cov, zero));
+	const auto high = Blend2(
+		_mm_unpackhi_epi8(dst, zero),
+		_mm_unpackhi_epi8(src, zero),
+		_mm_unpackhi_epi8(cov, zero));
+	return _mm_packus_epi16(low, high);
+}
+
+#endif // LOTTIE_SPANS_SSE2
+
+#ifdef LOTTIE_SPANS_AVX2
+
+[[nodiscard]] inline __m256i Div255x16(__m256i value) {
+	const auto rounded = _mm256_add_epi16(value, _mm256_set1_epi16(128));
+	return _mm256_srli_epi16(
+		_mm256_add_epi16(rounded, _mm256_srli_epi16(rounded, 8)),
+		8);
+}
+
+[[nodiscard]] inline __m256i Blend4x2(
+		__m256i dst,
+		__m256i src,
+		__m256i cov) {
+	const auto scaled = Div255x16(_mm256_mullo_epi16(src, cov));
+	const auto alpha = _mm256_shufflehi_epi16(
+		_mm256_shufflelo_epi16(scaled, _MM_SHUFFLE(3, 3, 3, 3)),
+		_MM_SHUFFLE(3, 3, 3, 3));
+	const auto inverted = _mm256_sub_epi16(_mm256_set1_epi16(255), alpha);
+	return _mm256_add_epi16(
+		scaled,
+		Div255x16(_mm256_mullo_epi16(dst, inverted)));
+}
+
+// The unpack instructions work inside 128 bit lanes, so the pixel order
+// is preserved as long as both the pixels and the coverage use it.
+[[nodiscard]] inline __m256i Blend8(__m256i dst, __m256i src, __m256i cov) {
+	const auto zero = _mm256_setzero_si256();
+	const auto low = Blend4x2(
+		_mm256_unpacklo_epi8(dst, zero),
+		_mm256_unpacklo_epi8(src, zero),
+		_mm256_unpacklo_epi8(cov, zero));
+	const auto high = Blend4x2(
+		_mm256_unpackhi_epi8(dst, zero),
+		_mm256_unpackhi_epi8(src, zero),
+		_mm256_unpackhi_epi8(cov, zero));
+	return _mm256_packus_epi16(low, high);
+}
+
+[[nodiscard]] inline __m256i ExpandCoverage8(const uint8_t *coverage) {
+	return _mm256_inserti128_si256(
+		_mm256_castsi128_si256(ExpandCoverage4(LoadCoverage4(coverage))),
+		ExpandCoverage4(LoadCoverage4(coverage + 4)),
+		1);
+}
+
+#endif // LOTTIE_SPANS_AVX2
+
+#ifdef LOTTIE_SPANS_NEON
+
+[[nodiscard]] inline uint8x8_t Div255x8(uint16x8_t value) {
+	const auto rounded = vaddq_u16(value, vdupq_n_u16(128));
+	return vmovn_u16(vshrq_n_u16(
+		vaddq_u16(rounded, vshrq_n_u16(rounded, 8)),
+		8));
+}
+
+[[nodiscard]] inline uint8x16_t ExpandCoverage4(uint32_t coverage) {
+	const auto bytes = vreinterpret_u8_u32(vdup_n_u32(coverage));
+	const auto doubled = vzip_u8(bytes, bytes).val[0];
+	const auto quadrupled = vzip_u8(doubled, doubled);
+	return vcombine_u8(quadrupled.val[0], quadrupled.val[1]);
+}
+
+[[nodiscard]] inline uint8x16_t Blend4(
+		uint8x16_t dst,
+		uint8x16_t src,
+		uint8x16_t cov) {
+	const auto scaled = vcombine_u8(
+		Div255x8(vmull_u8(vget_low_u8(src), vget_low_u8(cov))),
+		Div255x8(vmull_u8(vget_high_u8(src), vget_high_u8(cov))));
+	const auto alpha = vshrq_n_u32(vreinterpretq_u32_u8(scaled), 24);
+	const auto inverted = vmvnq_u8(vreinterpretq_u8_u32(
+		vmulq_n_u32(alpha, 0x01010101U)));
+	const auto kept = vcombine_u8(
+		Div255x8(vmull_u8(vget_low_u8(dst), vget_low_u8(inverted))),
+		Div255x8(vmull_u8(vget_high_u8(dst), vget_high_u8(inverted))));
+	return vaddq_u8(scaled, kept);
+}
+
+#endif // LOTTIE_SPANS_NEON
+
+// Rec. 601 weights in 1/256, they sum up to 256.
+constexpr auto kLumaRed = 54U;
+constexpr auto kLumaGreen = 183U;
+constexpr auto kLumaBlue = 19U;
+
+[[nodiscard]] inline uint32_t PixelLuma(uint32_t pixel) {
+	return (((pixel >> 16) & 0xFFU) * kLumaRed
+		+ ((pixel >> 8) & 0xFFU) * kLumaGreen
+		+ (pixel & 0xFFU) * kLumaBlue
+		+ 128U) >> 8;
+}
+
+} // namespace
+
+void BlendSolidSpan(
+		uint32_t *dst,
+		int count,
+		const uint8_t *coverage,
+		uint32_t color) {
+	auto i = 0;
+#if defined LOTTIE_SPANS_AVX2
+	const auto src8 = _mm256_set1_epi32(int(color));
+	for (; i + 8 <= count; i += 8) {
+		const auto address = reinterpret_cast<__m256i*>(dst + i);
+		_mm256_storeu_si256(address, Blend8(
+			_mm256_loadu_si256(address),
+			src8,
+			ExpandCoverage8(coverage + i)));
+	}
+#endif // LOTTIE_SPANS_AVX2
+#if defined LOTTIE_SPANS_SSE2
+	const auto src4 = _mm_set1_epi32(int(color));
+	for (; i + 4 <= count; i += 4) {
+		const auto address = reinterpret_cast<__m128i*>(dst + i);
+		_mm_storeu_si128(address, Blend4(
+			_mm_loadu_si128(address),
+			src4,
+			ExpandCoverage4(LoadCoverage4(coverage + i))));
+	}
+#elif defined LOTTIE_SPANS_NEON
+	const auto src4 = vreinterpretq_u8_u32(vdupq_n_u32(color));
+	for (; i + 4 <= count; i += 4) {
+		const auto address = reinterpret_cast<uint8_t*>(dst + i);
+		vst1q_u8(address, Blend4(
+			vld1q_u8(address),
+			src4,
+			ExpandCoverage4(LoadCoverage4(coverage + i))));
+	}
+#endif // LOTTIE_SPANS_SSE2 || LOTTIE_SPANS_NEON
+	const auto opaque = ((color >> 24) == 255U);
+	for (; i != count; ++i) {
+		const auto alpha = uint32_t(coverage[i]);
+		if (alpha == 255U && opaque) {
+			dst[i] = color;
+		} else if (alpha) {
+			dst[i] = BlendPixel(dst[i], ScalePixel(color, alpha));
+		}
+	}
+}
+
+void BlendBufferSpan(
+		uint32_t *dst,
+		int count,
+		const uint8_t *coverage,
+		const uint32_t *src) {
+	auto i = 0;
+#if defined LOTTIE_SPANS_AVX2
+	for (; i + 8 <= count; i += 8) {
+		const auto address = reinterpret_cast<__m256i*>(dst + i);
+		_mm256_storeu_si256(address, Blend8(
+			_mm256_loadu_si256(address),
+			_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)),
+			ExpandCoverage8(coverage + i)));
+	}
+#endif // LOTTIE_SPANS_AVX2
+#if defined LOTTIE_SPANS_SSE2
+	for (; i + 4 <= count; i += 4) {
+		const auto address = reinterpret_cast<__m128i*>(dst + i);
+		_mm_storeu_si128(address, Blend4(
+			_mm_loadu_si128(address),
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)),
+			ExpandCoverage4(LoadCoverage4(coverage + i))));
+	}
+#elif defined LOTTIE_SPANS_NEON
+	for (; i + 4 <= count; i += 4) {
+		const auto address = reinterpret_cast<uint8_t*>(dst + i);
+		vst1q_u8(address, Blend4(
+			vld1q_u8(address),
+			vld1q_u8(reinterpret_cast<const uint8_t*>(src + i)),
+			ExpandCoverage4(LoadCoverage4(coverage + i))));
+	}
+#endif // LOTTIE_SPANS_SSE2 || LOTTIE_SPANS_NEON
+	for (; i != count; ++i) {
+		if (const auto alpha = uint32_t(coverage[i])) {
+			dst[i] = BlendPixel(dst[i], ScalePixel(src[i], alpha));
+		}
+	}
+}
+
+void ScaleSpan(uint32_t *pixels, int count, const uint8_t *coverage) {
+	auto i = 0;
+#if defined LOTTIE_SPANS_SSE2
+	const auto zero = _mm_setzero_si128();
+	for (; i + 4 <= count; i += 4) {
+		const auto address = reinterpret_cast<__m128i*>(pixels + i);
+		const auto values = _mm_loadu_si128(address);
+		const auto cov = ExpandCoverage4(LoadCoverage4(coverage + i));
+		const auto low = Div255x8(_mm_mullo_epi16(
+			_mm_unpacklo_epi8(values, zero),
+			_mm_unpacklo_epi8(cov, zero)));
+		const auto high = Div255x8(_mm_mullo_epi16(
+			_mm_unpackhi_epi8(values, zero),
+			_mm_unpackhi_epi8(cov, zero)));
+		_mm_storeu_si128(address, _mm_packus_epi16(low, high));
+	}
+#elif defined LOTTIE_SPANS_NEON
+	for (; i + 4 <= count; i += 4) {
+		const auto address = reinterpret_cast<uint8_t*>(pixels + i);
+		const auto values = vld1q_u8(address);
+		const auto cov = ExpandCoverage4(LoadCoverage4(coverage + i));
+		vst1q_u8(address, vcombine_u8(
+			Div255x8(vmull_u8(vget_low_u8(values), vget_low_u8(cov))),
+			Div255x8(vmull_u8(vget_high_u8(values), vget_high_u8(cov)))));
+	}
+#endif // LOTTIE_SPANS_SSE2 || LOTTIE_SPANS_NEON
+	for (; i != count; ++i) {
+		pixels[i] = ScalePixel(pixels[i], coverage[i]);
+	}
+}
+
+void MultiplyCoverage(uint8_t *coverage, int count, const uint8_t *mask) {
+	for (auto i = 0; i != count; ++i) {
+		coverage[i] = uint8_t(Div255(uint32_t(coverage[i]) * mask[i]));
+	}
+}
+
+void MatteCoverage(
+		uint8_t *coverage,
+		int count,
+		const uint32_t *matte,
+		MatteOperation operation) {
+	const auto luma = (operation == MatteOperation::Luma)
+		|| (operation == MatteOperation::InvertedLuma);
+	const auto flip = (operation == MatteOperation::InvertedAlpha)
+		|| (operation == MatteOperation::InvertedLuma);
+	auto i = 0;
+#if defined LOTTIE_SPANS_SSE2
+	const auto zero = _mm_setzero_si128();
+	const auto weights = _mm_setr_epi16(
+		short(kLumaBlue),
+		short(kLumaGreen),
+		short(kLumaRed),
+		0,
+		short(kLumaBlue),
+		short(kLumaGreen),
+		short(kLumaRed),
+		0);
+	const auto mask = _mm_set1_epi8(flip ? char(0xFF) : char(0));
+	for (; i + 4 <= count; i += 4) {
+		const auto pixels = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(matte + i));
+		auto values = __m128i();
+		if (luma) {
+			// Sum (blue, green) and (red, alpha) pairs of each pixel.
+			const auto low = _mm_madd_epi16(
+				_mm_unpacklo_epi8(pixels, zero),
+				weights);
+			const auto high = _mm_madd_epi16(
+				_mm_unpackhi_epi8(pixels, zero),
+				weights);
+			const auto lowSums = _mm_add_epi32(
+				low,
+				_mm_shuffle_epi32(low, _MM_SHUFFLE(2, 3, 0, 1)));
+			const auto highSums = _mm_add_epi32(
+				high,
+				_mm_shuffle_epi32(high, _MM_SHUFFLE(2, 3, 0, 1)));
+			values = _mm_unpacklo_epi64(
+				_mm_shuffle_epi32(lowSums, _MM_SHUFFLE(3, 3, 2, 0)),
+				_mm_shuffle_epi32(highSums, _MM_SHUFFLE(3, 3, 2, 0)));
+			values = _mm_srli_epi32(
+				_mm_add_epi32(values, _mm_set1_epi32(128)),
+				8);
+		} else {
+			values = _mm_srli_epi32(pixels, 24);
+		}
+		const auto packed = _mm_packus_epi16(
+			_mm_packs_epi32(values, zero),
+			zero);
+		const auto result = _mm_xor_si128(packed, mask);
+		const auto bytes = uint32_t(_mm_cvtsi128_si32(result));
+		memcpy(coverage + i, &bytes, sizeof(bytes));
+	}
+#elif defined LOTTIE_SPANS_NEON
+	const auto mask = vdup_n_u8(flip ? 0xFF : 0);
+	for (; i + 8 <= count; i += 8) {
+		const auto channels = vld4_u8(
+			reinterpret_cast<const uint8_t*>(matte + i));
+		auto values = channels.val[3];
+		if (luma) {
+			const auto red = vdup_n_u8(uint8_t(kLumaRed));
+			const auto green = vdup_n_u8(uint8_t(kLumaGreen));
+			const auto blue = vdup_n_u8(uint8_t(kLumaBlue));
+			auto sum = vmull_u8(channels.val[2], red);
+			sum = vmlal_u8(sum, channels.val[1], green);
+			sum = vmlal_u8(sum, channels.val[0], blue);
+			values = vrshrn_n_u16(sum, 8);
+		}
+		vst1_u8(coverage + i, veor_u8(values, mask));
+	}
+#endif // LOTTIE_SPANS_SSE2 || LOTTIE_SPANS_NEON
+	const auto inversion = flip ? 0xFFU : 0U;
+	for (; i != count; ++i) {
+		const auto value = luma ? PixelLuma(matte[i]) : (matte[i] >> 24);
+		coverage[i] = uint8_t(value ^ inversion);
+	}
+}
+
+void CombineMask(
+		uint8_t *mask,
+		int count,
+		const uint8_t *coverage,
+		MaskOperation operation,
+		bool inverted,
+		uint8_t alpha) {
+	const auto flip = inverted ? 255U : 0U;
+	for (auto i = 0; i != count; ++i) {
+		const auto shape = Div255((uint32_t(coverage[i]) ^ flip) * alpha);
+		const auto value = uint32_t(mask[i]);
+		switch (operation) {
+		case MaskOperation::Add:
+			mask[i] = uint8_t(value + Div255((255U - value) * shape));
+			break;
+		case MaskOperation::Subtract:
+			mask[i] = uint8_t(Div255(value * (255U - shape)));
+			break;
+		case MaskOperation::Intersect:
+			mask[i] = uint8_t(Div255(value * shape));
+			break;
+		}
+	}
+}
+
+void SwapRedBlue(uint32_t *pixels, int count) {
+	auto i = 0;
+#if defined LOTTIE_SPANS_SSE2
+	const auto greenAlpha = _mm_set1_epi32(int(0xFF00FF00U));
+	const auto blue = _mm_set1_epi32(0xFF);
+	for (; i + 4 <= count; i += 4) {
+		const auto address = reinterpret_cast<__m128i*>(pixels + i);
+		const auto values = _mm_loadu_si128(address);
+		const auto kept = _mm_and_si128(values, greenAlpha);
+		const auto swapped = _mm_or_si128(
+			_mm_slli_epi32(_mm_and_si128(values, blue), 16),
+			_mm_and_si128(_mm_srli_epi32(values, 16), blue));
+		_mm_storeu_si128(address, _mm_or_si128(kept, swapped));
+	}
+#elif defined LOTTIE_SPANS_NEON
+	for (; i + 8 <= count; i += 8) {
+		const auto bytes = reinterpret_cast<uint8_t*>(pixels + i);
+		auto channels = vld4_u8(bytes);
+		const auto first = channels.val[0];
+		channels.val[0] = channels.val[2];
+		channels.val[2] = first;
+		vst4_u8(bytes, channels);
+	}
+#endif // LOTTIE_SPANS_SSE2 || LOTTIE_SPANS_NEON
+	for (; i != count; ++i) {
+		const auto pixel = pixels[i];
+		pixels[i] = (pixel & 0xFF00FF00U)
+			| ((pixel & 0xFFU) << 16)
+			| ((pixel >> 16) & 0xFFU);
+	}
+}
+
+} // namespace Lottie
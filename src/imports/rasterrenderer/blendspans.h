@@ -0,0 +1,93 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include <cstdint>
+
+namespace Lottie {
+
+// All the pixels are premultiplied 0xAARRGGBB, coverage is in [0, 255].
+// SIMD variants are selected at compile time and produce exactly the
+// same bytes as the scalar code.
+
+[[nodiscard]] inline uint32_t Div255(uint32_t value) {
+	value += 128;
+	return (value + (value >> 8)) >> 8;
+}
+
+[[nodiscard]] inline uint32_t ScalePixel(uint32_t pixel, uint32_t alpha) {
+	return Div255((pixel & 0xFFU) * alpha)
+		| (Div255(((pixel >> 8) & 0xFFU) * alpha) << 8)
+		| (Div255(((pixel >> 16) & 0xFFU) * alpha) << 16)
+		| (Div255((pixel >> 24) * alpha) << 24);
+}
+
+[[nodiscard]] inline uint32_t BlendPixel(uint32_t dst, uint32_t src) {
+	return src + ScalePixel(dst, 255U - (src >> 24));
+}
+
+// Premultiplies a straight 0xAARRGGBB color.
+[[nodiscard]] inline uint32_t PremultiplyPixel(uint32_t argb) {
+	const auto alpha = argb >> 24;
+	return (ScalePixel(argb | 0xFF000000U, alpha) & 0x00FFFFFFU)
+		| (alpha << 24);
+}
+
+void BlendSolidSpan(
+	uint32_t *dst,
+	int count,
+	const uint8_t *coverage,
+	uint32_t color);
+void BlendBufferSpan(
+	uint32_t *dst,
+	int count,
+	const uint8_t *coverage,
+	const uint32_t *src);
+
+// pixels[i] = pixels[i] * coverage[i] / 255.
+void ScaleSpan(uint32_t *pixels, int count, const uint8_t *coverage);
+
+// coverage[i] = coverage[i] * mask[i] / 255.
+void MultiplyCoverage(uint8_t *coverage, int count, const uint8_t *mask);
+
+enum class MaskOperation {
+	Add,
+	Subtract,
+	Intersect,
+};
+
+// Combines a shape coverage into a mask, the shape coverage is inverted
+// if needed and multiplied by alpha first.
+void CombineMask(
+	uint8_t *mask,
+	int count,
+	const uint8_t *coverage,
+	MaskOperation operation,
+	bool inverted,
+	uint8_t alpha);
+
+enum class MatteOperation {
+	Alpha,
+	InvertedAlpha,
+	Luma,
+	InvertedLuma,
+};
+
+// Turns track matte pixels into coverage of the matted layer. Luma is
+// taken from the premultiplied color, as if the matte was over black.
+void MatteCoverage(
+	uint8_t *coverage,
+	int count,
+	const uint32_t *matte,
+	MatteOperation operation);
+
+// Swaps red and blue, so that the pixels are in the RGBA byte order
+// on the little endian platforms, or back.
+void SwapRedBlue(uint32_t *pixels, int count);
+
+} // namespace Lottie
@@ -0,0 +1,144 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "boundscanvas.h"
+
+#include "bmstroke.h"
+
+#include <QPainterPath>
+
+namespace Lottie {
+
+BoundsCanvas::BoundsCanvas(QSize size)
+: _size(size) {
+}
+
+QRectF BoundsCanvas::bounds() const {
+	return _bounds;
+}
+
+QSize BoundsCanvas::size() const {
+	return _size;
+}
+
+void BoundsCanvas::save() {
+	_stack.push_back(_state);
+}
+
+void BoundsCanvas::restore() {
+	if (!_stack.empty()) {
+		_state = std::move(_stack.back());
+		_stack.pop_back();
+	}
+}
+
+QTransform BoundsCanvas::transform() const {
+	return _state.transform;
+}
+
+void BoundsCanvas::setTransform(const QTransform &transform) {
+	_state.transform = transform;
+}
+
+qreal BoundsCanvas::opacity() const {
+	return _state.opacity;
+}
+
+void BoundsCanvas::setOpacity(qreal opacity) {
+	_state.opacity = opacity;
+}
+
+void BoundsCanvas::setBrush(const QBrush &brush) {
+	_state.brush = brush;
+}
+
+void BoundsCanvas::setGradientBrush(
+		const QBrush &brush,
+		std::shared_ptr<const GradientTable> table) {
+	_state.brush = brush;
+}
+
+void BoundsCanvas::setPen(const QPen &pen) {
+	_state.pen = pen;
+}
+
+void BoundsCanvas::drawPath(const QPainterPath &path) {
+	if (_state.opacity <= 0. || path.isEmpty()) {
+		return;
+	}
+	const auto rect = path.boundingRect();
+	if (_state.brush.style() != Qt::NoBrush) {
+		add(_state.transform.mapRect(rect));
+	}
+	const auto &pen = _state.pen;
+	if (pen.style() == Qt::NoPen) {
+		return;
+	}
+	const auto extent = BMStroke::Extent(pen);
+	if (pen.isCosmetic()) {
+		add(_state.transform.mapRect(rect).adjusted(
+			-extent,
+			-extent,
+			extent,
+			extent));
+	} else {
+		add(_state.transform.mapRect(rect.adjusted(
+			-extent,
+			-extent,
+			extent,
+			extent)));
+	}
+}
+
+void BoundsCanvas::drawPathInstances(
+		const QPainterPath &path,
+		const std::vector<Instance> &instances) {
+	const auto saved = _state;
+	for (const auto &instance : instances) {
+		_state.transform = instance.transform;
+		_state.opacity = instance.opacity;
+		drawPath(path);
+	}
+	_state = saved;
+}
+
+void BoundsCanvas::drawImage(const QRectF &target, const QImage &image) {
+	if (_state.opacity > 0.) {
+		add(_state.transform.mapRect(target));
+	}
+}
+
+void BoundsCanvas::setClipPath(const QPainterPath &path) {
+}
+
+void BoundsCanvas::addMask(
+		const QPainterPath &path,
+		MaskMode mode,
+		bool inverted,
+		qreal opacity) {
+}
+
+void BoundsCanvas::applyMask() {
+}
+
+void BoundsCanvas::beginMatteLayer() {
+}
+
+void BoundsCanvas::endMatteLayer() {
+}
+
+void BoundsCanvas::beginMattedLayer(MatteMode mode) {
+}
+
+void BoundsCanvas::endMattedLayer() {
+}
+
+void BoundsCanvas::add(const QRectF &rect) {
+	_bounds = _bounds.isEmpty() ? rect : _bounds.united(rect);
+}
+
+} // namespace Lottie
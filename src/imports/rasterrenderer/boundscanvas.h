@@ -0,0 +1,85 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "canvas.h"
+
+#include <QTransform>
+#include <QBrush>
+#include <QPen>
+#include <QRectF>
+#include <QSize>
+
+#include <vector>
+
+namespace Lottie {
+
+// Draws nothing, only measures the device rect that drawing would touch.
+// Clips, masks and mattes are ignored and strokes are estimated, so the
+// result can be larger than the painted area, but never smaller.
+class BoundsCanvas final : public Canvas {
+public:
+	explicit BoundsCanvas(QSize size);
+
+	[[nodiscard]] QRectF bounds() const;
+
+	[[nodiscard]] QSize size() const override;
+
+	void save() override;
+	void restore() override;
+
+	[[nodiscard]] QTransform transform() const override;
+	void setTransform(const QTransform &transform) override;
+
+	[[nodiscard]] qreal opacity() const override;
+	void setOpacity(qreal opacity) override;
+
+	void setBrush(const QBrush &brush) override;
+	void setGradientBrush(
+		const QBrush &brush,
+		std::shared_ptr<const GradientTable> table) override;
+	void setPen(const QPen &pen) override;
+
+	void drawPath(const QPainterPath &path) override;
+	void drawPathInstances(
+		const QPainterPath &path,
+		const std::vector<Instance> &instances) override;
+	void drawImage(const QRectF &target, const QImage &image) override;
+
+	void setClipPath(const QPainterPath &path) override;
+
+	void addMask(
+		const QPainterPath &path,
+		MaskMode mode,
+		bool inverted,
+		qreal opacity) override;
+	void applyMask() override;
+
+	void beginMatteLayer() override;
+	void endMatteLayer() override;
+	void beginMattedLayer(MatteMode mode) override;
+	void endMattedLayer() override;
+
+private:
+	struct State {
+		QTransform transform;
+		qreal opacity = 1.;
+		QBrush brush;
+		QPen pen;
+	};
+
+	void add(const QRectF &rect);
+
+	QSize _size;
+	QRectF _bounds;
+	State _state;
+	std::vector<State> _stack;
+
+};
+
+} // namespace Lottie
@@ -0,0 +1,107 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "gradienttable.h"
+
+#include <QtGlobal>
+#include <QTransform>
+
+#include <memory>
+#include <vector>
+
+class QSize;
+class QRectF;
+class QImage;
+class QBrush;
+class QPen;
+class QPainterPath;
+
+namespace Lottie {
+
+// The part of QPainter that RasterRenderer draws with, so the same
+// renderer can target either QPainter or the native scanline backend.
+class Canvas {
+public:
+	enum class MaskMode {
+		Add,
+		Subtract,
+		Intersect,
+	};
+	enum class MatteMode {
+		Alpha,
+		InvertedAlpha,
+		Luma,
+		InvertedLuma,
+	};
+	struct Instance {
+		QTransform transform;
+		qreal opacity = 1.;
+	};
+
+	virtual ~Canvas() = default;
+
+	[[nodiscard]] virtual QSize size() const = 0;
+
+	// Saves and restores transform, opacity, brush, pen and clip.
+	virtual void save() = 0;
+	virtual void restore() = 0;
+
+	[[nodiscard]] virtual QTransform transform() const = 0;
+	virtual void setTransform(const QTransform &transform) = 0;
+
+	[[nodiscard]] virtual qreal opacity() const = 0;
+	virtual void setOpacity(qreal opacity) = 0;
+
+	virtual void setBrush(const QBrush &brush) = 0;
+
+	// A gradient brush with the colors already computed from its stops.
+	virtual void setGradientBrush(
+		const QBrush &brush,
+		std::shared_ptr<const GradientTable> table) = 0;
+	virtual void setPen(const QPen &pen) = 0;
+
+	// Fills with the brush and then strokes with the pen.
+	virtual void drawPath(const QPainterPath &path) = 0;
+
+	// Same as drawing the path with each of the transforms and opacities
+	// in turn and restoring them afterwards, but the work that doesn't
+	// depend on them, like stroking, is done only once.
+	virtual void drawPathInstances(
+		const QPainterPath &path,
+		const std::vector<Instance> &instances) = 0;
+
+	// Draws a premultiplied ARGB32 image scaled into the target rect,
+	// filtered bilinearly.
+	virtual void drawImage(const QRectF &target, const QImage &image) = 0;
+
+	// Replaces the clip, an empty path hides everything.
+	virtual void setClipPath(const QPainterPath &path) = 0;
+
+	// Combines a path into the mask being built. When the first path is
+	// not added the mask starts from the whole canvas.
+	virtual void addMask(
+		const QPainterPath &path,
+		MaskMode mode,
+		bool inverted,
+		qreal opacity) = 0;
+
+	// Intersects the clip with the built mask and starts a new one.
+	virtual void applyMask() = 0;
+
+	// Track mattes: the matte layer is drawn into an offscreen layer and
+	// kept, then the next matted layer is drawn into another offscreen
+	// layer and composited through the kept matte.
+	virtual void beginMatteLayer() = 0;
+	virtual void endMatteLayer() = 0;
+	virtual void beginMattedLayer(MatteMode mode) = 0;
+	virtual void endMattedLayer() = 0;
+
+};
+
+} // namespace Lottie
@@ -0,0 +1,208 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "displaylist.h"
+
+namespace Lottie {
+
+DisplayList::DisplayList(QSize size)
+: _size(size) {
+}
+
+void DisplayList::replay(Canvas &canvas, const QTransform &base) const {
+	// The transform set before replaying is replaced, same as opacity.
+	canvas.setTransform(base);
+	auto instances = std::vector<Instance>();
+	for (const auto &command : _commands) {
+		replay(command, canvas, base, instances);
+	}
+}
+
+void DisplayList::replay(
+		const Command &command,
+		Canvas &canvas,
+		const QTransform &base,
+		std::vector<Instance> &instances) const {
+	switch (command.type) {
+	case Type::Save: canvas.save(); break;
+	case Type::Restore: canvas.restore(); break;
+	case Type::SetTransform:
+		canvas.setTransform(_transforms[command.index] * base);
+		break;
+	case Type::SetOpacity: canvas.setOpacity(command.value); break;
+	case Type::SetBrush: {
+		const auto &brush = _brushes[command.index];
+		if (brush.table) {
+			canvas.setGradientBrush(brush.brush, brush.table);
+		} else {
+			canvas.setBrush(brush.brush);
+		}
+	} break;
+	case Type::SetPen: canvas.setPen(_pens[command.index]); break;
+	case Type::DrawPath: canvas.drawPath(_paths[command.index]); break;
+	case Type::DrawPathInstances: {
+		const auto &recorded = _instances[command.index];
+		instances.clear();
+		for (const auto &instance : recorded.list) {
+			instances.push_back({ instance.transform * base, instance.opacity });
+		}
+		canvas.drawPathInstances(recorded.path, instances);
+	} break;
+	case Type::DrawImage: {
+		const auto &image = _images[command.index];
+		canvas.drawImage(image.target, image.image);
+	} break;
+	case Type::SetClipPath: canvas.setClipPath(_paths[command.index]); break;
+	case Type::AddMask:
+		canvas.addMask(
+			_paths[command.index],
+			MaskMode(command.mode),
+			command.inverted,
+			command.value);
+		break;
+	case Type::ApplyMask: canvas.applyMask(); break;
+	case Type::BeginMatteLayer: canvas.beginMatteLayer(); break;
+	case Type::EndMatteLayer: canvas.endMatteLayer(); break;
+	case Type::BeginMattedLayer:
+		canvas.beginMattedLayer(MatteMode(command.mode));
+		break;
+	case Type::EndMattedLayer: canvas.endMattedLayer(); break;
+	}
+}
+
+void DisplayList::clear() {
+	_commands.clear();
+	_transforms.clear();
+	_brushes.clear();
+	_pens.clear();
+	_paths.clear();
+	_instances.clear();
+	_images.clear();
+	_state = State();
+	_stack.clear();
+}
+
+bool DisplayList::empty() const {
+	return _commands.empty();
+}
+
+QSize DisplayList::size() const {
+	return _size;
+}
+
+void DisplayList::add(Type type, int index, qreal value) {
+	auto command = Command();
+	command.type = type;
+	command.index = index;
+	command.value = value;
+	_commands.push_back(command);
+}
+
+void DisplayList::save() {
+	_stack.push_back(_state);
+	add(Type::Save);
+}
+
+void DisplayList::restore() {
+	if (!_stack.empty()) {
+		_state = _stack.back();
+		_stack.pop_back();
+	}
+	add(Type::Restore);
+}
+
+QTransform DisplayList::transform() const {
+	return _state.transform;
+}
+
+void DisplayList::setTransform(const QTransform &transform) {
+	_state.transform = transform;
+	_transforms.push_back(transform);
+	add(Type::SetTransform, int(_transforms.size()) - 1);
+}
+
+qreal DisplayList::opacity() const {
+	return _state.opacity;
+}
+
+void DisplayList::setOpacity(qreal opacity) {
+	_state.opacity = opacity;
+	add(Type::SetOpacity, 0, opacity);
+}
+
+void DisplayList::setBrush(const QBrush &brush) {
+	_brushes.push_back({ brush });
+	add(Type::SetBrush, int(_brushes.size()) - 1);
+}
+
+void DisplayList::setGradientBrush(
+		const QBrush &brush,
+		std::shared_ptr<const GradientTable> table) {
+	_brushes.push_back({ brush, std::move(table) });
+	add(Type::SetBrush, int(_brushes.size()) - 1);
+}
+
+void DisplayList::setPen(const QPen &pen) {
+	_pens.push_back(pen);
+	add(Type::SetPen, int(_pens.size()) - 1);
+}
+
+void DisplayList::drawPath(const QPainterPath &path) {
+	_paths.push_back(path);
+	add(Type::DrawPath, int(_paths.size()) - 1);
+}
+
+void DisplayList::drawPathInstances(
+		const QPainterPath &path,
+		const std::vector<Instance> &instances) {
+	_instances.push_back({ path, instances });
+	add(Type::DrawPathInstances, int(_instances.size()) - 1);
+}
+
+void DisplayList::drawImage(const QRectF &target, const QImage &image) {
+	_images.push_back({ target, image });
+	add(Type::DrawImage, int(_images.size()) - 1);
+}
+
+void DisplayList::setClipPath(const QPainterPath &path) {
+	_paths.push_back(path);
+	add(Type::SetClipPath, int(_paths.size()) - 1);
+}
+
+void DisplayList::addMask(
+		const QPainterPath &path,
+		MaskMode mode,
+		bool inverted,
+		qreal opacity) {
+	_paths.push_back(path);
+	add(Type::AddMask, int(_paths.size()) - 1, opacity);
+	_commands.back().mode = uchar(mode);
+	_commands.back().inverted = inverted;
+}
+
+void DisplayList::applyMask() {
+	add(Type::ApplyMask);
+}
+
+void DisplayList::beginMatteLayer() {
+	add(Type::BeginMatteLayer);
+}
+
+void DisplayList::endMatteLayer() {
+	add(Type::EndMatteLayer);
+}
+
+void DisplayList::beginMattedLayer(MatteMode mode) {
+	add(Type::BeginMattedLayer);
+	_commands.back().mode = uchar(mode);
+}
+
+void DisplayList::endMattedLayer() {
+	add(Type::EndMattedLayer);
+}
+
+} // namespace Lottie
@@ -0,0 +1,142 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "canvas.h"
+
+#include <QTransform>
+#include <QBrush>
+#include <QPen>
+#include <QPainterPath>
+#include <QImage>
+#include <QRectF>
+#include <QSize>
+
+#include <vector>
+
+namespace Lottie {
+
+// Records the canvas calls of a renderer instead of drawing, so that the
+// scene is traversed once and the list is replayed onto any canvas later,
+// on any thread and with an additional transform, for example to draw
+// the same frame at another size. Paths, brushes and images are
+// implicitly shared with the scene, so recording copies little.
+class DisplayList final : public Canvas {
+public:
+	explicit DisplayList(QSize size);
+
+	// Drawn as if the recorded transforms were followed by the base one.
+	void replay(Canvas &canvas, const QTransform &base = QTransform()) const;
+
+	void clear();
+	[[nodiscard]] bool empty() const;
+
+	[[nodiscard]] QSize size() const override;
+
+	void save() override;
+	void restore() override;
+
+	[[nodiscard]] QTransform transform() const override;
+	void setTransform(const QTransform &transform) override;
+
+	[[nodiscard]] qreal opacity() const override;
+	void setOpacity(qreal opacity) override;
+
+	void setBrush(const QBrush &brush) override;
+	void setGradientBrush(
+		const QBrush &brush,
+		std::shared_ptr<const GradientTable> table) override;
+	void setPen(const QPen &pen) override;
+
+	void drawPath(const QPainterPath &path) override;
+	void drawPathInstances(
+		const QPainterPath &path,
+		const std::vector<Instance> &instances) override;
+	void drawImage(const QRectF &target, const QImage &image) override;
+
+	void setClipPath(const QPainterPath &path) override;
+
+	void addMask(
+		const QPainterPath &path,
+		MaskMode mode,
+		bool inverted,
+		qreal opacity) override;
+	void applyMask() override;
+
+	void beginMatteLayer() override;
+	void endMatteLayer() override;
+	void beginMattedLayer(MatteMode mode) override;
+	void endMattedLayer() override;
+
+private:
+	enum class Type : uchar {
+		Save,
+		Restore,
+		SetTransform,
+		SetOpacity,
+		SetBrush,
+		SetPen,
+		DrawPath,
+		DrawPathInstances,
+		DrawImage,
+		SetClipPath,
+		AddMask,
+		ApplyMask,
+		BeginMatteLayer,
+		EndMatteLayer,
+		BeginMattedLayer,
+		EndMattedLayer,
+	};
+
+	// The arguments are kept in the typed arrays below, the index points
+	// to the one of the array for the command type.
+	struct Command {
+		Type type = Type::Save;
+		uchar mode = 0;
+		bool inverted = false;
+		int index = 0;
+		qreal value = 0.;
+	};
+	struct Brush {
+		QBrush brush;
+		std::shared_ptr<const GradientTable> table;
+	};
+	struct Instances {
+		QPainterPath path;
+		std::vector<Instance> list;
+	};
+	struct Image {
+		QRectF target;
+		QImage image;
+	};
+	struct State {
+		QTransform transform;
+		qreal opacity = 1.;
+	};
+
+	void add(Type type, int index = 0, qreal value = 0.);
+	void replay(
+		const Command &command,
+		Canvas &canvas,
+		const QTransform &base,
+		std::vector<Instance> &instances) const;
+
+	QSize _size;
+	std::vector<Command> _commands;
+	std::vector<QTransform> _transforms;
+	std::vector<Brush> _brushes;
+	std::vector<QPen> _pens;
+	std::vector<QPainterPath> _paths;
+	std::vector<Instances> _instances;
+	std::vector<Image> _images;
+	State _state;
+	std::vector<State> _stack;
+
+};
+
+} // namespace Lottie
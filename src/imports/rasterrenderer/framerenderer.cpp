@@ -0,0 +1,169 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "framerenderer.h"
+
+#include "bmscene.h"
+#include "parallel.h"
+#include "displaylist.h"
+#include "rasterrenderer.h"
+#include "scanlinecanvas.h"
+#include "blendspans.h"
+
+#include <QImage>
+#include <QTransform>
+#include <QDebug>
+
+#include <algorithm>
+#include <memory>
+
+namespace Lottie {
+namespace {
+
+// Cached layer bitmaps in a list are recorded for its largest image and
+// shouldn't be minified more than that for the smaller ones.
+constexpr auto kMaxListMinification = 2.;
+
+struct Target {
+	QImage *image = nullptr;
+	QTransform transform;
+	qreal scale = 0.;
+	const DisplayList *list = nullptr;
+};
+
+// Native endian 0xAARRGGBB words to R, G, B, A bytes.
+void ConvertToRGBA8888(uint32_t *pixels, int count) {
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+	SwapRedBlue(pixels, count);
+#else // Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+	for (const auto till = pixels + count; pixels != till; ++pixels) {
+		*pixels = (*pixels << 8) | (*pixels >> 24);
+	}
+#endif // Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+}
+
+} // namespace
+
+bool RenderFrame(
+		BMScene &scene,
+		int frame,
+		const std::vector<QImage*> &targets,
+		StrokeCache *strokes) {
+	if (scene.width() <= 0 || scene.height() <= 0) {
+		return false;
+	}
+	auto sorted = std::vector<Target>();
+	sorted.reserve(targets.size());
+	for (const auto image : targets) {
+		if (image->format() != QImage::Format_ARGB32_Premultiplied) {
+			qWarning() << "RenderFrame: Unsupported target image format";
+			continue;
+		}
+		const auto scaleX = image->width() / qreal(scene.width());
+		const auto scaleY = image->height() / qreal(scene.height());
+		image->fill(Qt::transparent);
+		sorted.push_back({
+			image,
+			QTransform::fromScale(scaleX, scaleY),
+			std::max(scaleX, scaleY),
+		});
+	}
+	if (sorted.empty()) {
+		return false;
+	}
+	std::sort(begin(sorted), end(sorted), [](
+			const Target &a,
+			const Target &b) {
+		return a.scale > b.scale;
+	});
+
+	scene.updateProperties(frame);
+
+	// Each image is drawn with the list recorded for the largest of its
+	// close sizes, scaled down by the replay transform.
+	auto lists = std::vector<std::unique_ptr<DisplayList>>();
+	auto recordedScale = qreal(0.);
+	auto recordedInverted = QTransform();
+	for (auto &target : sorted) {
+		if (lists.empty()
+			|| target.scale * kMaxListMinification < recordedScale) {
+			lists.push_back(std::make_unique<DisplayList>(
+				target.image->size()));
+			const auto list = lists.back().get();
+			list->setTransform(target.transform);
+			auto renderer = RasterRenderer(list);
+			scene.render(renderer, frame);
+
+			recordedScale = target.scale;
+			recordedInverted = target.transform.inverted();
+		}
+		target.list = lists.back().get();
+		target.transform = recordedInverted * target.transform;
+	}
+	ParallelFor(int(sorted.size()), [&](int index) {
+		const auto &target = sorted[index];
+		auto canvas = ScanlineCanvas(
+			target.image,
+			ScanlineCanvas::Mode::Immediate,
+			nullptr,
+			strokes);
+		target.list->replay(canvas, target.transform);
+		canvas.finish();
+	});
+	return true;
+}
+
+void RenderFrame(
+		BMScene &scene,
+		int frame,
+		const std::vector<FrameBuffer> &targets,
+		StrokeCache *strokes) {
+	auto images = std::vector<QImage>();
+	auto formats = std::vector<PixelFormat>();
+	images.reserve(targets.size());
+	formats.reserve(targets.size());
+	for (const auto &target : targets) {
+		const auto aligned = !(reinterpret_cast<quintptr>(target.data) % 4)
+			&& !(target.bytesPerLine % 4);
+		if (!target.data
+			|| !aligned
+			|| target.size.isEmpty()
+			|| target.bytesPerLine < target.size.width() * 4) {
+			qWarning() << "RenderFrame: Bad frame buffer";
+			continue;
+		}
+		// The image uses the buffer memory as long as it is not copied.
+		images.emplace_back(
+			target.data,
+			target.size.width(),
+			target.size.height(),
+			target.bytesPerLine,
+			QImage::Format_ARGB32_Premultiplied);
+		formats.push_back(target.format);
+	}
+	auto pointers = std::vector<QImage*>();
+	pointers.reserve(images.size());
+	for (auto &image : images) {
+		pointers.push_back(&image);
+	}
+	if (!RenderFrame(scene, frame, pointers, strokes)) {
+		return;
+	}
+	ParallelFor(int(images.size()), [&](int index) {
+		if (formats[index] != PixelFormat::RGBA8888Premultiplied) {
+			return;
+		}
+		auto &image = images[index];
+		for (auto y = 0, height = image.height(); y != height; ++y) {
+			ConvertToRGBA8888(
+				reinterpret_cast<uint32_t*>(image.scanLine(y)),
+				image.width());
+		}
+	});
+}
+
+} // namespace Lottie
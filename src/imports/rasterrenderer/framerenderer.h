@@ -0,0 +1,61 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include <QSize>
+
+#include <vector>
+
+class QImage;
+
+namespace Lottie {
+
+class BMScene;
+class StrokeCache;
+
+// Draws one frame of the scene into each of the premultiplied ARGB32
+// images, scaled to fill them. The properties are evaluated once and the
+// scene is traversed into a display list once for all the images of
+// close sizes, so a thumbnail drawn with the full size frame costs only
+// its rasterization. The images are rasterized in parallel.
+//
+// Returns false if nothing was drawn because the scene is empty, the
+// images are left untouched then.
+bool RenderFrame(
+	BMScene &scene,
+	int frame,
+	const std::vector<QImage*> &targets,
+	StrokeCache *strokes = nullptr);
+
+// Both formats have premultiplied alpha, straight alpha output like
+// QImage::Format_RGBA8888 is not supported.
+enum class PixelFormat {
+	// QImage::Format_ARGB32_Premultiplied, native endian 0xAARRGGBB words.
+	ARGB32Premultiplied,
+
+	// QImage::Format_RGBA8888_Premultiplied, R, G, B, A bytes.
+	RGBA8888Premultiplied,
+};
+
+// Memory owned by the caller, like a pooled or shared memory buffer,
+// aligned to four bytes.
+struct FrameBuffer {
+	uchar *data = nullptr;
+	int bytesPerLine = 0;
+	QSize size;
+	PixelFormat format = PixelFormat::ARGB32Premultiplied;
+};
+
+// Same as above, but draws straight into the buffers, without copying.
+void RenderFrame(
+	BMScene &scene,
+	int frame,
+	const std::vector<FrameBuffer> &targets,
+	StrokeCache *strokes = nullptr);
+
+} // namespace Lottie
@@ -0,0 +1,397 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "paintercanvas.h"
+
+#include "blendspans.h"
+#include "strokecache.h"
+
+#include <QPainter>
+#include <QPainterPath>
+#include <QTransform>
+#include <QBrush>
+#include <QPen>
+#include <QSize>
+
+#include <algorithm>
+
+namespace Lottie {
+namespace {
+
+constexpr auto kMaxPooledImages = 4;
+
+// Offscreen layers for track mattes, reused between frames.
+[[nodiscard]] std::vector<QImage> &ImagesPool() {
+	thread_local auto result = std::vector<QImage>();
+	return result;
+}
+
+[[nodiscard]] QImage AcquireImage(
+		QSize size,
+		QImage::Format format = QImage::Format_ARGB32_Premultiplied) {
+	auto &pool = ImagesPool();
+	for (auto i = pool.begin(); i != pool.end(); ++i) {
+		if (i->size() == size && i->format() == format) {
+			auto result = std::move(*i);
+			pool.erase(i);
+			result.fill(Qt::transparent);
+			return result;
+		}
+	}
+	auto result = QImage(size, format);
+	result.fill(Qt::transparent);
+	return result;
+}
+
+void ReleaseImage(QImage &&image) {
+	if (image.isNull()) {
+		return;
+	}
+	auto &pool = ImagesPool();
+	if (pool.size() >= size_t(kMaxPooledImages)) {
+		pool.erase(pool.begin());
+	}
+	pool.push_back(std::move(image));
+}
+
+[[nodiscard]] MaskOperation ToMaskOperation(Canvas::MaskMode mode) {
+	switch (mode) {
+	case Canvas::MaskMode::Subtract: return MaskOperation::Subtract;
+	case Canvas::MaskMode::Intersect: return MaskOperation::Intersect;
+	default: return MaskOperation::Add;
+	}
+}
+
+} // namespace
+
+PainterCanvas::PainterCanvas(QPainter *painter, StrokeCache *strokes)
+: _painter(painter)
+, _strokes(strokes) {
+}
+
+void PainterCanvas::setupPainter(QPainter &painter) const {
+	painter.setRenderHints(_painter->renderHints());
+}
+
+QSize PainterCanvas::size() const {
+	return QSize(_painter->device()->width(), _painter->device()->height());
+}
+
+void PainterCanvas::save() {
+	_painter->save();
+	++_saveDepth;
+}
+
+void PainterCanvas::restore() {
+	endMaskedLayers();
+	_painter->restore();
+	--_saveDepth;
+}
+
+QTransform PainterCanvas::transform() const {
+	return _painter->transform();
+}
+
+void PainterCanvas::setTransform(const QTransform &transform) {
+	_painter->setTransform(transform);
+}
+
+qreal PainterCanvas::opacity() const {
+	return _painter->opacity();
+}
+
+void PainterCanvas::setOpacity(qreal opacity) {
+	_painter->setOpacity(opacity);
+}
+
+void PainterCanvas::setBrush(const QBrush &brush) {
+	_painter->setBrush(brush);
+}
+
+// QPainter keeps its own cache of the gradient color tables.
+void PainterCanvas::setGradientBrush(
+		const QBrush &brush,
+		std::shared_ptr<const GradientTable> table) {
+	_painter->setBrush(brush);
+}
+
+void PainterCanvas::setPen(const QPen &pen) {
+	_painter->setPen(pen);
+}
+
+void PainterCanvas::drawPath(const QPainterPath &path) {
+	if (!_strokes) {
+		_painter->drawPath(path);
+		return;
+	}
+	const auto pen = _painter->pen();
+	if (pen.style() == Qt::NoPen || pen.isCosmetic()) {
+		_painter->drawPath(path);
+		return;
+	}
+	_painter->setPen(Qt::NoPen);
+	_painter->drawPath(path);
+	_painter->fillPath(_strokes->outline(path, pen), pen.brush());
+	_painter->setPen(pen);
+}
+
+void PainterCanvas::drawPathInstances(
+		const QPainterPath &path,
+		const std::vector<Instance> &instances) {
+	const auto transform = _painter->transform();
+	const auto opacity = _painter->opacity();
+	const auto pen = _painter->pen();
+	const auto outline = (_strokes
+		&& pen.style() != Qt::NoPen
+		&& !pen.isCosmetic());
+	const auto stroke = outline
+		? _strokes->outline(path, pen)
+		: QPainterPath();
+	if (outline) {
+		_painter->setPen(Qt::NoPen);
+	}
+	for (const auto &instance : instances) {
+		_painter->setTransform(instance.transform);
+		_painter->setOpacity(instance.opacity);
+		_painter->drawPath(path);
+		if (outline) {
+			_painter->fillPath(stroke, pen.brush());
+		}
+	}
+	if (outline) {
+		_painter->setPen(pen);
+	}
+	_painter->setTransform(transform);
+	_painter->setOpacity(opacity);
+}
+
+void PainterCanvas::drawImage(const QRectF &target, const QImage &image) {
+	const auto smooth = _painter->testRenderHint(
+		QPainter::SmoothPixmapTransform);
+	_painter->setRenderHint(QPainter::SmoothPixmapTransform);
+	_painter->drawImage(target, image);
+	_painter->setRenderHint(QPainter::SmoothPixmapTransform, smooth);
+}
+
+void PainterCanvas::setClipPath(const QPainterPath &path) {
+	_painter->setClipPath(path);
+}
+
+void PainterCanvas::addMask(
+		const QPainterPath &path,
+		MaskMode mode,
+		bool inverted,
+		qreal opacity) {
+	_masks.push_back({ path, mode, inverted, opacity });
+}
+
+void PainterCanvas::applyMask() {
+	if (_masks.empty()) {
+		return;
+	}
+	const auto translucent = std::any_of(
+		_masks.begin(),
+		_masks.end(),
+		[](const Mask &mask) { return !qFuzzyCompare(mask.opacity, 1.); });
+	if (translucent) {
+		beginMaskedLayer();
+	} else {
+		_painter->setClipPath(maskPath(), Qt::IntersectClip);
+	}
+	_masks.clear();
+}
+
+// Opaque masks are combined exactly, as a clip path.
+QPainterPath PainterCanvas::maskPath() {
+	auto result = (_masks.front().mode == MaskMode::Add)
+		? QPainterPath()
+		: screen();
+	for (const auto &mask : _masks) {
+		const auto shape = mask.inverted ? (screen() - mask.path) : mask.path;
+		if (mask.mode == MaskMode::Add) {
+			_addedMasks.push_back(shape);
+			continue;
+		}
+		uniteAddedMasks(result);
+		result = (mask.mode == MaskMode::Subtract)
+			? result.subtracted(shape)
+			: result.intersected(shape);
+	}
+	uniteAddedMasks(result);
+	return result;
+}
+
+void PainterCanvas::uniteAddedMasks(QPainterPath &mask) {
+	if (_addedMasks.empty()) {
+		return;
+	}
+	while (_addedMasks.size() > 1) {
+		const auto count = _addedMasks.size();
+		for (auto i = size_t(0); i + 1 < count; i += 2) {
+			_addedMasks[i / 2] = _addedMasks[i].united(_addedMasks[i + 1]);
+		}
+		if (count % 2) {
+			_addedMasks[count / 2] = std::move(_addedMasks.back());
+		}
+		_addedMasks.resize((count + 1) / 2);
+	}
+	mask = mask.isEmpty()
+		? _addedMasks.front()
+		: mask.united(_addedMasks.front());
+	_addedMasks.clear();
+}
+
+// Translucent masks are combined as coverage, the same way ScanlineCanvas
+// does, and the layer is drawn offscreen and scaled by it on restore().
+void PainterCanvas::beginMaskedLayer() {
+	const auto full = (_masks.front().mode != MaskMode::Add);
+	auto coverage = AcquireImage(size(), QImage::Format_Alpha8);
+	coverage.fill(full ? 255U : 0U);
+	auto shape = AcquireImage(size(), QImage::Format_Alpha8);
+	const auto width = coverage.width();
+	const auto height = coverage.height();
+	for (const auto &mask : _masks) {
+		shape.fill(0U);
+		auto painter = QPainter(&shape);
+		setupPainter(painter);
+		painter.setTransform(_painter->transform());
+		painter.fillPath(mask.path, Qt::black);
+		painter.end();
+
+		const auto operation = ToMaskOperation(mask.mode);
+		const auto alpha = uint8_t(std::clamp(
+			qRound(mask.opacity * 255.),
+			0,
+			255));
+		for (auto y = 0; y != height; ++y) {
+			CombineMask(
+				coverage.scanLine(y),
+				width,
+				shape.constScanLine(y),
+				operation,
+				mask.inverted,
+				alpha);
+		}
+	}
+	ReleaseImage(std::move(shape));
+
+	beginLayer();
+	_layers.back().mask = std::move(coverage);
+	_layers.back().maskDepth = _saveDepth;
+}
+
+void PainterCanvas::endMaskedLayers() {
+	while (!_layers.empty() && _layers.back().maskDepth == _saveDepth) {
+		auto layer = endLayer();
+		auto &image = layer.image;
+		for (auto y = 0, height = image.height(); y != height; ++y) {
+			ScaleSpan(
+				reinterpret_cast<uint32_t*>(image.scanLine(y)),
+				image.width(),
+				layer.mask.constScanLine(y));
+		}
+		drawLayer(image);
+		ReleaseImage(std::move(layer.image));
+		ReleaseImage(std::move(layer.mask));
+	}
+}
+
+void PainterCanvas::beginMatteLayer() {
+	beginLayer();
+}
+
+void PainterCanvas::endMatteLayer() {
+	endMaskedLayers();
+	if (!_layers.empty()) {
+		ReleaseImage(std::exchange(_matte, endLayer().image));
+	}
+}
+
+void PainterCanvas::beginMattedLayer(MatteMode mode) {
+	beginLayer();
+	_layers.back().matte = std::exchange(_matte, QImage());
+	_layers.back().mode = mode;
+}
+
+void PainterCanvas::endMattedLayer() {
+	endMaskedLayers();
+	if (_layers.empty()) {
+		return;
+	}
+	auto layer = endLayer();
+	auto &image = layer.image;
+	const auto operation = [&] {
+		switch (layer.mode) {
+		case MatteMode::InvertedAlpha: return MatteOperation::InvertedAlpha;
+		case MatteMode::Luma: return MatteOperation::Luma;
+		case MatteMode::InvertedLuma: return MatteOperation::InvertedLuma;
+		default: return MatteOperation::Alpha;
+		}
+	}();
+	const auto inverted = (operation == MatteOperation::InvertedAlpha)
+		|| (operation == MatteOperation::InvertedLuma);
+	const auto width = image.width();
+	auto coverage = std::vector<uint8_t>(width, inverted ? 255 : 0);
+	for (auto y = 0, height = image.height(); y != height; ++y) {
+		const auto pixels = reinterpret_cast<uint32_t*>(image.scanLine(y));
+		if (!layer.matte.isNull()) {
+			MatteCoverage(
+				coverage.data(),
+				width,
+				reinterpret_cast<const uint32_t*>(
+					layer.matte.constScanLine(y)),
+				operation);
+		}
+		ScaleSpan(pixels, width, coverage.data());
+	}
+	drawLayer(image);
+	ReleaseImage(std::move(layer.image));
+	ReleaseImage(std::move(layer.matte));
+}
+
+void PainterCanvas::beginLayer() {
+	auto layer = Layer();
+	layer.image = AcquireImage(size());
+	layer.painter = std::make_unique<QPainter>(&layer.image);
+	setupPainter(*layer.painter);
+	layer.painter->setTransform(_painter->transform());
+	layer.painter->setOpacity(_painter->opacity());
+	layer.painter->setBrush(_painter->brush());
+	layer.painter->setPen(_painter->pen());
+	if (_painter->hasClipping()) {
+		layer.painter->setClipPath(_painter->clipPath());
+	}
+	layer.previous = _painter;
+	_painter = layer.painter.get();
+	_layers.push_back(std::move(layer));
+}
+
+// The layer already has the clip and the opacity applied.
+void PainterCanvas::drawLayer(const QImage &image) {
+	_painter->save();
+	_painter->resetTransform();
+	_painter->setOpacity(1.);
+	_painter->setClipping(false);
+	_painter->drawImage(QPoint(), image);
+	_painter->restore();
+}
+
+auto PainterCanvas::endLayer() -> Layer {
+	auto result = std::move(_layers.back());
+	_layers.pop_back();
+	result.painter->end();
+	_painter = result.previous;
+	return result;
+}
+
+QPainterPath PainterCanvas::screen() const {
+	auto result = QPainterPath();
+	result.addRect(QRectF(QPointF(), size()));
+	return _painter->transform().inverted().map(result);
+}
+
+} // namespace Lottie
@@ -0,0 +1,112 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "canvas.h"
+
+#include <QPainterPath>
+#include <QImage>
+
+#include <memory>
+#include <vector>
+
+class QPainter;
+
+namespace Lottie {
+
+class StrokeCache;
+
+// With a stroke cache the strokes are filled as cached outlines instead
+// of being stroked by QPainter every time.
+class PainterCanvas final : public Canvas {
+public:
+	explicit PainterCanvas(QPainter *painter, StrokeCache *strokes = nullptr);
+
+	// Gives another painter the same render hints, so that it draws the
+	// same way as this canvas does.
+	void setupPainter(QPainter &painter) const;
+
+	[[nodiscard]] QSize size() const override;
+
+	void save() override;
+	void restore() override;
+
+	[[nodiscard]] QTransform transform() const override;
+	void setTransform(const QTransform &transform) override;
+
+	[[nodiscard]] qreal opacity() const override;
+	void setOpacity(qreal opacity) override;
+
+	void setBrush(const QBrush &brush) override;
+	void setGradientBrush(
+		const QBrush &brush,
+		std::shared_ptr<const GradientTable> table) override;
+	void setPen(const QPen &pen) override;
+
+	void drawPath(const QPainterPath &path) override;
+	void drawPathInstances(
+		const QPainterPath &path,
+		const std::vector<Instance> &instances) override;
+	void drawImage(const QRectF &target, const QImage &image) override;
+
+	void setClipPath(const QPainterPath &path) override;
+
+	// Opaque masks are combined with path boolean operations and clip,
+	// translucent ones draw the layer offscreen until restore().
+	void addMask(
+		const QPainterPath &path,
+		MaskMode mode,
+		bool inverted,
+		qreal opacity) override;
+	void applyMask() override;
+
+	void beginMatteLayer() override;
+	void endMatteLayer() override;
+	void beginMattedLayer(MatteMode mode) override;
+	void endMattedLayer() override;
+
+private:
+	struct Layer {
+		QImage image;
+		std::unique_ptr<QPainter> painter;
+		QPainter *previous = nullptr;
+		QImage matte;
+		MatteMode mode = MatteMode::Alpha;
+
+		// Coverage the layer is scaled by when restored to this depth.
+		QImage mask;
+		int maskDepth = -1;
+	};
+	struct Mask {
+		QPainterPath path;
+		MaskMode mode = MaskMode::Add;
+		bool inverted = false;
+		qreal opacity = 1.;
+	};
+
+	[[nodiscard]] QPainterPath screen() const;
+	[[nodiscard]] QPainterPath maskPath();
+	void uniteAddedMasks(QPainterPath &mask);
+	void beginMaskedLayer();
+	void endMaskedLayers();
+	void beginLayer();
+	[[nodiscard]] Layer endLayer();
+	void drawLayer(const QImage &image);
+
+	QPainter *_painter = nullptr;
+	StrokeCache *_strokes = nullptr;
+	std::vector<Mask> _masks;
+	// Added masks in a row are united pairwise, not one by one.
+	std::vector<QPainterPath> _addedMasks;
+	int _saveDepth = 0;
+	std::vector<Layer> _layers;
+	QImage _matte;
+
+};
+
+} // namespace Lottie
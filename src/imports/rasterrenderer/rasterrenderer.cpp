@@ -43,111 +43,191 @@
 #include "bmrepeater.h"
 #include "bmlayer.h"
 #include "bmmaskshape.h"
+#include "layercache.h"
+#include "boundscanvas.h"
+#include "scanlinecanvas.h"
 
 #include <QPainter>
+#include <QPen>
 #include <QRectF>
 #include <QBrush>
 #include <QTransform>
 #include <QGradient>
 #include <QPointer>
 #include <QVectorIterator>
+#include <QImage>
+
+#include <cmath>
 
 namespace Lottie {
+namespace {
+
+// A cached bitmap is drawn only while it is not magnified and is not
+// minified so much that the bilinear filtering starts to alias.
+constexpr auto kMaxCacheMagnification = 1.01;
+constexpr auto kMaxCacheMinification = 2.;
+
+// Layers with the scale changing from frame to frame are drawn as vectors
+// instead of being rasterized again and again, until the scale stays the
+// same for a while.
+constexpr auto kMaxCacheBuilds = 3;
+constexpr auto kCacheStableRenders = 30;
+constexpr auto kMaxCachePixels = 2048 * 2048;
+
+[[nodiscard]] bool Transparent(qreal opacity) {
+	return opacity * 255. < 0.5;
+}
+
+[[nodiscard]] qreal TransformScale(const QTransform &transform) {
+	return std::max(
+		std::hypot(transform.m11(), transform.m12()),
+		std::hypot(transform.m21(), transform.m22()));
+}
+
+[[nodiscard]] bool CacheFits(const LayerCacheImage &image, qreal scale) {
+	return (image.scale > 0.)
+		&& (scale <= image.scale * kMaxCacheMagnification)
+		&& (scale * kMaxCacheMinification >= image.scale);
+}
+
+} // namespace
+
+RasterRenderer::RasterRenderer(QPainter *painter, StrokeCache *strokes)
+: m_painterCanvas(std::make_unique<PainterCanvas>(painter, strokes))
+, m_canvas(m_painterCanvas.get())
+, m_visibleRect(QRectF(QPointF(), QSizeF(m_canvas->size()))) {
+	m_canvas->setPen(QPen(Qt::NoPen));
+}
 
-RasterRenderer::RasterRenderer(QPainter *painter)
-: m_painter(painter) {
-	m_painter->setPen(QPen(Qt::NoPen));
+RasterRenderer::RasterRenderer(Canvas *canvas)
+: m_canvas(canvas)
+, m_visibleRect(QRectF(QPointF(), QSizeF(m_canvas->size()))) {
+	m_canvas->setPen(QPen(Qt::NoPen));
+}
+
+void RasterRenderer::setVisibleRect(std::optional<QRectF> rect) {
+	m_visibleRect = rect;
+}
+
+bool RasterRenderer::visible(const QRectF &rect) const {
+	// Repeater copies and strokes set outside are not in the rect.
+	if (m_repeaterTransform || m_strokeExtent > 0.) {
+		return true;
+	}
+	return visibleInDevice(m_canvas->transform().mapRect(rect));
+}
+
+bool RasterRenderer::visibleInDevice(const QRectF &rect) const {
+	return !m_visibleRect || rect.intersects(*m_visibleRect);
 }
 
 void RasterRenderer::saveState() {
-	m_painter->save();
+	m_canvas->save();
 	saveTrimmingState();
-	m_pathStack.push_back(m_unitedPath);
 	m_fillEffectStack.push_back(m_fillEffect);
-	m_unitedPath = QPainterPath();
+	m_strokeExtentStack.push_back(m_strokeExtent);
+	++m_stateDepth;
 }
 
 void RasterRenderer::restoreState() {
-	m_painter->restore();
+	if (!m_matteLayers.isEmpty()
+		&& m_matteLayers.top().first == m_stateDepth) {
+		if (m_matteLayers.pop().second) {
+			m_canvas->endMattedLayer();
+		} else {
+			m_canvas->endMatteLayer();
+		}
+	}
+	if (m_repeaterTransform && m_repeaterDepth == m_stateDepth) {
+		m_repeaterTransform = nullptr;
+		m_repeatCount = 1;
+		m_repeatOffset = 0.0;
+	}
+	--m_stateDepth;
+	m_canvas->restore();
 	restoreTrimmingState();
-	m_unitedPath = m_pathStack.pop();
 	m_fillEffect = m_fillEffectStack.pop();
+	m_strokeExtent = m_strokeExtentStack.pop();
 }
 
 void RasterRenderer::render(const BMLayer &layer) {
+	// Both layers are drawn offscreen until the matching restoreState().
 	if (layer.isMaskLayer()) {
-		m_buildingClipRegion = true;
-	} else if (!m_clipPath.isEmpty()) {
-		if (layer.clipMode() == BMLayer::Alpha) {
-			m_painter->setClipPath(m_clipPath);
-		} else if (layer.clipMode() == BMLayer::InvertedAlpha) {
-			QPainterPath screen;
-			screen.addRect(
-				0,
-				0,
-				m_painter->device()->width(),
-				m_painter->device()->height());
-			m_painter->setClipPath(screen - m_clipPath);
-		} else {
-			// Clipping is not applied to paths that have
-			// not setting clipping parameters
-			m_painter->setClipPath(QPainterPath());
-		}
-		m_buildingClipRegion = false;
-		m_clipPath = QPainterPath();
+		m_canvas->beginMatteLayer();
+		m_matteLayers.push({ m_stateDepth, false });
+	} else if (layer.isClippedLayer()) {
+		const auto mode = [&] {
+			switch (layer.clipMode()) {
+			case BMLayer::InvertedAlpha: return Canvas::MatteMode::InvertedAlpha;
+			case BMLayer::Luminence: return Canvas::MatteMode::Luma;
+			case BMLayer::InvertedLuminence: return Canvas::MatteMode::InvertedLuma;
+			default: return Canvas::MatteMode::Alpha;
+			}
+		}();
+		m_canvas->beginMattedLayer(mode);
+		m_matteLayers.push({ m_stateDepth, true });
 	}
 }
 
 void RasterRenderer::renderGeometry(const BMShape &geometry) {
-	const auto withTransforms = (m_repeatCount > 1);
-	if (withTransforms) {
-		m_painter->save();
+	if (trimmingState() == Renderer::Individual) {
+		// The shapes are drawn trimmed together by render(BMTrimPath).
+		return;
+	} else if (m_buildingMergedGeometry) {
+		// The copies are drawn with the merged geometry.
+		m_mergedGeometry[m_buildingMergedGeometry - 1].add(geometry.path());
+	} else {
+		drawRepeated(geometry.path());
 	}
+}
 
+void RasterRenderer::drawRepeated(const QPainterPath &path) {
+	if (Transparent(m_canvas->opacity())) {
+		return;
+	}
+	const auto rect = path.controlPointRect().adjusted(
+		-m_strokeExtent,
+		-m_strokeExtent,
+		m_strokeExtent,
+		m_strokeExtent);
+	if (m_repeatCount <= 0) {
+		return;
+	} else if (m_repeatCount == 1) {
+		if (visibleInDevice(m_canvas->transform().mapRect(rect))) {
+			m_canvas->drawPath(path);
+		}
+		return;
+	}
+	auto transform = m_canvas->transform();
+	auto opacity = m_canvas->opacity();
+	m_repeaterInstances.clear();
 	for (int i = 0; i < m_repeatCount; i++) {
-		applyRepeaterTransform(i);
-		if (trimmingState() == Renderer::Individual) {
-			QTransform t = m_painter->transform();
-			QPainterPath tp = t.map(geometry.path());
-			tp.addPath(m_unitedPath);
-			m_unitedPath = tp;
-		} else if (m_buildingClipRegion) {
-			QTransform t = m_painter->transform();
-			QPainterPath tp = t.map(geometry.path());
-			tp.addPath(m_clipPath);
-			m_clipPath = tp;
-		} else if (m_buildingMergedGeometry) {
-			QPainterPath p = geometry.path();
-			p.addPath(m_mergedGeometry);
-			m_mergedGeometry = p;
-		} else {
-			m_painter->drawPath(geometry.path());
+		applyRepeaterTransform(i, transform, opacity);
+		if (!Transparent(opacity)
+			&& visibleInDevice(transform.mapRect(rect))) {
+			m_repeaterInstances.push_back({ transform, opacity });
 		}
 	}
-
-	if (withTransforms) {
-		m_painter->restore();
+	if (!m_repeaterInstances.empty()) {
+		m_canvas->drawPathInstances(path, m_repeaterInstances);
 	}
 }
 
 void RasterRenderer::startMergeGeometry() {
-	if (m_buildingMergedGeometry++) {
-		m_mergedGeometryStack.push_back(std::move(m_mergedGeometry));
-		m_mergedGeometry = QPainterPath();
+	if (int(m_mergedGeometry.size()) <= m_buildingMergedGeometry) {
+		m_mergedGeometry.emplace_back();
 	}
+	m_mergedGeometry[m_buildingMergedGeometry++].clear();
 }
 
 void RasterRenderer::renderMergedGeometry() {
 	Q_ASSERT(m_buildingMergedGeometry > 0);
 
-	if (!m_mergedGeometry.isEmpty()) {
-		m_painter->drawPath(m_mergedGeometry);
-	}
-
-	if (--m_buildingMergedGeometry) {
-		m_mergedGeometry = m_mergedGeometryStack.pop();
-	} else {
-		m_mergedGeometry = QPainterPath();
+	// Shapes are visited in the reverse order of their definition.
+	auto &geometry = m_mergedGeometry[--m_buildingMergedGeometry];
+	if (!geometry.empty()) {
+		drawRepeated(geometry.result(PathAccumulator::Order::Reversed));
+		geometry.clear();
 	}
 }
 
@@ -170,7 +250,11 @@ void RasterRenderer::render(const BMFill &fill) {
 
 	QColor color(fill.color());
 	color.setAlphaF(color.alphaF() * fill.opacity() / 100.);
-	m_painter->setBrush(color);
+	if (color.alpha()) {
+		m_canvas->setBrush(color);
+	} else {
+		m_canvas->setBrush(QBrush(Qt::NoBrush));
+	}
 }
 
 void RasterRenderer::render(const BMGFill &gradient) {
@@ -178,9 +262,9 @@ void RasterRenderer::render(const BMGFill &gradient) {
 		return;
 	}
 
-	m_painter->setOpacity(m_painter->opacity() * gradient.opacity() / 100.);
+	m_canvas->setOpacity(m_canvas->opacity() * gradient.opacity() / 100.);
 	if (gradient.value()) {
-		m_painter->setBrush(*gradient.value());
+		m_canvas->setGradientBrush(*gradient.value(), gradient.table());
 	} else {
 		qWarning() << "Gradient:"
 			<< "Cannot draw gradient fill";
@@ -192,16 +276,22 @@ void RasterRenderer::render(const BMStroke &stroke) {
 		return;
 	}
 
-	m_painter->setPen(stroke.pen());
+	if (stroke.pen().color().alpha()) {
+		m_canvas->setPen(stroke.pen());
+		m_strokeExtent = stroke.extent();
+	} else {
+		m_canvas->setPen(QPen(Qt::NoPen));
+		m_strokeExtent = 0.;
+	}
 }
 
 void RasterRenderer::render(const BMBasicTransform &transform) {
 	renderWithoutOpacity(transform);
-	m_painter->setOpacity(m_painter->opacity() * transform.opacity());
+	m_canvas->setOpacity(m_canvas->opacity() * transform.opacity());
 }
 
 void RasterRenderer::renderWithoutOpacity(const BMBasicTransform &transform) {
-	m_painter->setTransform(transform.apply(m_painter->transform()));
+	m_canvas->setTransform(transform.apply(m_canvas->transform()));
 }
 
 void RasterRenderer::render(const BMShapeTransform &transform) {
@@ -213,29 +303,16 @@ void RasterRenderer::render(const BMFreeFormShape &shape) {
 }
 
 void RasterRenderer::render(const BMTrimPath &trimPath) {
-	// TODO: Remove "Individual" trimming to the prerendering thread
-	// Now it is done in the GUI thread
-
-	m_painter->save();
-
-	for (int i = 0; i < m_repeatCount; i++) {
-		applyRepeaterTransform(i);
-		if (!trimPath.simultaneous() && !qFuzzyCompare(0.0, m_unitedPath.length())) {
-			QPainterPath tr = trimPath.trim(m_unitedPath);
-			// Do not use the applied transform, as the transform
-			// is already included in m_unitedPath
-			m_painter->setTransform(QTransform());
-			m_painter->drawPath(tr);
-		}
+	// The "Individual" trimming was done with the properties update.
+	if (!trimPath.simultaneous() && !trimPath.individualPath().isEmpty()) {
+		drawRepeated(trimPath.individualPath());
 	}
-
-	m_painter->restore();
 }
 
 void RasterRenderer::render(const BMFillEffect &effect) {
 	m_fillEffect = &effect;
-	m_painter->setBrush(m_fillEffect->color());
-	m_painter->setOpacity(m_painter->opacity() * m_fillEffect->opacity());
+	m_canvas->setBrush(m_fillEffect->color());
+	m_canvas->setOpacity(m_canvas->opacity() * m_fillEffect->opacity());
 }
 
 void RasterRenderer::render(const BMRepeater &repeater) {
@@ -246,24 +323,28 @@ void RasterRenderer::render(const BMRepeater &repeater) {
 
 	m_repeatCount = repeater.copies();
 	m_repeatOffset = repeater.offset();
+	m_repeaterDepth = m_stateDepth;
 
 	// Can store pointer to transform, although the transform
 	// is managed by another thread. The object will be available
 	// until the frame has been rendered
 	m_repeaterTransform = &repeater.transform();
 
-	m_painter->translate(
+	QTransform t = m_canvas->transform();
+	t.translate(
 		m_repeatOffset * m_repeaterTransform->position().x(),
 		m_repeatOffset * m_repeaterTransform->position().y());
+	m_canvas->setTransform(t);
 }
 
-void RasterRenderer::applyRepeaterTransform(int instance) {
+void RasterRenderer::applyRepeaterTransform(
+		int instance,
+		QTransform &t,
+		qreal &opacity) const {
 	if (!m_repeaterTransform || instance == 0) {
 		return;
 	}
 
-	QTransform t = m_painter->transform();
-
 	QPointF anchors = -m_repeaterTransform->anchorPoint();
 	QPointF position = m_repeaterTransform->position();
 	QPointF anchoredCenter = anchors + position;
@@ -273,38 +354,128 @@ void RasterRenderer::applyRepeaterTransform(int instance) {
 	t.scale(
 		m_repeaterTransform->scale().x(),
 		m_repeaterTransform->scale().y());
-	m_painter->setTransform(t);
-
-	qreal o = m_repeaterTransform->opacityAtInstance(instance);
 
-	m_painter->setOpacity(m_painter->opacity() * o);
+	opacity *= m_repeaterTransform->opacityAtInstance(instance);
 }
 
 void RasterRenderer::render(const BMMasks &masks) {
-	if (m_buildingMaskRegion) {
-		m_buildingMaskRegion = false;
-		m_painter->setClipPath(m_maskPath);
+	m_canvas->applyMask();
+}
+
+bool RasterRenderer::renderCached(const BMLayer &layer, int frame) {
+	const auto cache = layer.contentCache();
+	if (!cache || m_fillEffect || trimmingState() != Renderer::Off) {
+		return false;
+	} else if (!qFuzzyCompare(m_canvas->opacity(), 1.)) {
+		// Translucent vector contents are blended fill by fill, so where
+		// the shapes overlap they look different from a translucent image.
+		return false;
 	}
+	const auto scale = TransformScale(m_canvas->transform());
+	if (scale <= 0.) {
+		return true;
+	}
+	QMutexLocker lock(&cache->mutex);
+	if (!qFuzzyCompare(scale, cache->lastScale)) {
+		cache->lastScale = scale;
+		cache->stableRenders = 0;
+	} else if (cache->stableRenders < kCacheStableRenders
+		&& ++cache->stableRenders == kCacheStableRenders) {
+		cache->builds = 0;
+	}
+	const auto count = int(cache->images.size());
+	auto index = 0;
+	while (index != count && !CacheFits(cache->images[index], scale)) {
+		++index;
+	}
+	if (index == count) {
+		if (cache->builds >= kMaxCacheBuilds) {
+			return false;
+		}
+		++cache->builds;
+		index = (cache->lastUsed + 1) % count;
+		if (!buildCache(cache->images[index], layer, frame, scale)) {
+			cache->builds = kMaxCacheBuilds;
+			return false;
+		}
+	}
+	cache->lastUsed = index;
+	const auto &image = cache->images[index];
+	if (!image.image.isNull()) {
+		m_canvas->drawImage(image.rect, image.image);
+	}
+	return true;
 }
 
-void RasterRenderer::render(const BMMaskShape &shape) {
-	QPainterPath path;
-	if (shape.inverted()) {
-		QPainterPath screen;
-		screen.addRect(0, 0, m_painter->device()->width(),
-			m_painter->device()->height());
-		path = screen - shape.path();
-	} else {
-		path = shape.path();
+bool RasterRenderer::buildCache(
+		LayerCacheImage &cache,
+		const BMLayer &layer,
+		int frame,
+		qreal scale) const {
+	const auto transform = QTransform::fromScale(scale, scale);
+	auto measure = BoundsCanvas(m_canvas->size());
+	measure.setTransform(transform);
+	{
+		auto renderer = RasterRenderer(&measure);
+		renderer.setVisibleRect(std::nullopt);
+		layer.renderContents(renderer, frame);
+	}
+
+	// One transparent pixel around lets the filtering fade out the edges.
+	const auto bounds = measure.bounds();
+	const auto left = int(std::floor(bounds.x())) - 1;
+	const auto top = int(std::floor(bounds.y())) - 1;
+	const auto width = int(std::ceil(bounds.x() + bounds.width())) + 1 - left;
+	const auto height = int(std::ceil(bounds.y() + bounds.height())) + 1 - top;
+	if (bounds.isEmpty()) {
+		cache.image = QImage();
+		cache.rect = QRectF();
+		cache.scale = scale;
+		return true;
+	} else if (qint64(width) * height > kMaxCachePixels) {
+		cache = LayerCacheImage();
+		return false;
 	}
-	if (!m_buildingMaskRegion) {
-		m_buildingMaskRegion = true;
-		m_maskPath = path;
-	} else if (shape.mode() == BMMaskShape::Mode::Additive) {
-		m_maskPath = m_maskPath.united(path);
-	} else if (shape.mode() == BMMaskShape::Mode::Intersect) {
-		m_maskPath = m_maskPath.intersected(path);
+	auto image = QImage(width, height, QImage::Format_ARGB32_Premultiplied);
+	image.fill(Qt::transparent);
+	const auto shift = transform * QTransform::fromTranslate(-left, -top);
+
+	// Rasterized by the same backend, so that the edges are the same.
+	if (const auto painter = dynamic_cast<PainterCanvas*>(m_canvas)) {
+		auto target = QPainter(&image);
+		painter->setupPainter(target);
+		target.setTransform(shift);
+		auto renderer = RasterRenderer(&target);
+		layer.renderContents(renderer, frame);
+	} else {
+		auto canvas = ScanlineCanvas(&image);
+		canvas.setTransform(shift);
+		auto renderer = RasterRenderer(&canvas);
+		layer.renderContents(renderer, frame);
 	}
+	cache.image = std::move(image);
+	cache.rect = QRectF(
+		left / scale,
+		top / scale,
+		width / scale,
+		height / scale);
+	cache.scale = scale;
+	return true;
+}
+
+void RasterRenderer::render(const BMMaskShape &shape) {
+	const auto mode = [&] {
+		switch (shape.mode()) {
+		case BMMaskShape::Mode::Subtract: return Canvas::MaskMode::Subtract;
+		case BMMaskShape::Mode::Intersect: return Canvas::MaskMode::Intersect;
+		default: return Canvas::MaskMode::Add;
+		}
+	}();
+	m_canvas->addMask(
+		shape.path(),
+		mode,
+		shape.inverted(),
+		shape.opacity() / 100.);
 }
 
 } // namespace Lottie
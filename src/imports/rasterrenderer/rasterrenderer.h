@@ -30,18 +30,34 @@
 
 #include <QPainterPath>
 #include <QStack>
+#include <QRectF>
 
 #include "renderer.h"
+#include "paintercanvas.h"
+#include "pathaccumulator.h"
+
+#include <memory>
+#include <optional>
+#include <vector>
 
 class QPainter;
 
 namespace Lottie {
 
 class BMShape;
+class StrokeCache;
+struct LayerCacheImage;
 
 class RasterRenderer final : public Renderer {
 public:
-	explicit RasterRenderer(QPainter *m_painter);
+	explicit RasterRenderer(
+		QPainter *painter,
+		StrokeCache *strokes = nullptr);
+	explicit RasterRenderer(Canvas *canvas);
+
+	// Drawing outside of the rect in the device coordinates is skipped,
+	// it is the whole canvas by default, nullopt draws everything.
+	void setVisibleRect(std::optional<QRectF> rect);
 
 	void startMergeGeometry() override;
 	void renderMergedGeometry() override;
@@ -67,28 +83,43 @@ public:
 	void render(const BMMaskShape &shape) override;
 	void render(const BMMasks &masks) override;
 
+	bool renderCached(const BMLayer &layer, int frame) override;
+	bool visible(const QRectF &rect) const override;
+
 protected:
-	QPainter *m_painter = nullptr;
-	QPainterPath m_unitedPath;
-	// TODO: create a context to handle paths and effect
-	// instead of pushing each to a stack independently
-	QStack<QPainterPath> m_pathStack;
+	std::unique_ptr<PainterCanvas> m_painterCanvas;
+	Canvas *m_canvas = nullptr;
 	QStack<const BMFillEffect*> m_fillEffectStack;
 	const BMFillEffect *m_fillEffect = nullptr;
+	QStack<qreal> m_strokeExtentStack;
+	qreal m_strokeExtent = 0.;
+	std::optional<QRectF> m_visibleRect;
 	const BMRepeaterTransform *m_repeaterTransform = nullptr;
 	int m_repeatCount = 1;
 	qreal m_repeatOffset = 0.0;
-	bool m_buildingClipRegion = false;
-	QPainterPath m_clipPath;
+	// The repeater applies until the state it was set in is restored.
+	int m_repeaterDepth = 0;
+	std::vector<Canvas::Instance> m_repeaterInstances;
+	int m_stateDepth = 0;
+	// State depths of the layers drawn offscreen for track mattes.
+	QStack<std::pair<int, bool>> m_matteLayers;
+	// Geometry merged in each nesting level, kept to reuse the storage.
+	std::vector<PathAccumulator> m_mergedGeometry;
 	int m_buildingMergedGeometry = 0;
-	QPainterPath m_mergedGeometry;
-	QStack<QPainterPath> m_mergedGeometryStack;
-	bool m_buildingMaskRegion = false;
-	QPainterPath m_maskPath;
 
 private:
-	void applyRepeaterTransform(int instance);
+	void applyRepeaterTransform(
+		int instance,
+		QTransform &transform,
+		qreal &opacity) const;
 	void renderGeometry(const BMShape &geometry);
+	void drawRepeated(const QPainterPath &path);
+	[[nodiscard]] bool visibleInDevice(const QRectF &rect) const;
+	bool buildCache(
+		LayerCacheImage &cache,
+		const BMLayer &layer,
+		int frame,
+		qreal scale) const;
 
 };
 
@@ -0,0 +1,1114 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "scanlinecanvas.h"
+
+#include "blendspans.h"
+#include "parallel.h"
+#include "strokecache.h"
+#include "bmstroke.h"
+
+#include <QImage>
+#include <QPainterPath>
+#include <QPainterPathStroker>
+#include <QLinearGradient>
+#include <QRadialGradient>
+#include <QSize>
+#include <QDebug>
+
+#include <array>
+#include <optional>
+#include <unordered_map>
+#include <cmath>
+#include <cstring>
+
+namespace Lottie {
+namespace {
+
+constexpr auto kBandHeight = 32;
+
+// Clip coverages kept by a band, enough for a few levels of nested masks.
+constexpr auto kMaxBandClips = 8;
+
+// Paths smaller than a quarter of a pixel in both dimensions, strokes
+// included, cover at most a sixteenth of a pixel and are skipped.
+constexpr auto kMinPathSize = 0.25;
+
+// QPainter needs the focal point inside the circle as well.
+constexpr auto kMaxFocalDistance = 0.999;
+
+[[nodiscard]] uint32_t SolidColor(const QColor &color, qreal opacity) {
+	const auto argb = uint32_t(color.rgba());
+	const auto alpha = uint32_t(std::lround((argb >> 24) * opacity));
+	return PremultiplyPixel((argb & 0x00FFFFFFU) | (alpha << 24));
+}
+
+// The weights are in 1/256 and add up to 256 for each direction.
+[[nodiscard]] uint32_t InterpolatePixel256(
+		uint32_t a,
+		uint32_t aWeight,
+		uint32_t b,
+		uint32_t bWeight) {
+	const auto redBlue = (((a & 0x00FF00FFU) * aWeight
+		+ (b & 0x00FF00FFU) * bWeight) >> 8) & 0x00FF00FFU;
+	const auto alphaGreen = (((a >> 8) & 0x00FF00FFU) * aWeight
+		+ ((b >> 8) & 0x00FF00FFU) * bWeight) & 0xFF00FF00U;
+	return redBlue | alphaGreen;
+}
+
+// Coverage buffers for clips and masks, reused between bands and frames.
+[[nodiscard]] std::vector<std::vector<uint8_t>> &CoveragePool() {
+	thread_local auto result = std::vector<std::vector<uint8_t>>();
+	return result;
+}
+
+[[nodiscard]] std::vector<uint8_t> AcquireCoverage() {
+	auto &pool = CoveragePool();
+	if (pool.empty()) {
+		return {};
+	}
+	auto result = std::move(pool.back());
+	pool.pop_back();
+	return result;
+}
+
+void ReleaseCoverage(std::vector<uint8_t> &&buffer) {
+	CoveragePool().push_back(std::move(buffer));
+}
+
+// Offscreen layers for track mattes, same as the coverage pool.
+[[nodiscard]] std::vector<std::vector<uint32_t>> &PixelsPool() {
+	thread_local auto result = std::vector<std::vector<uint32_t>>();
+	return result;
+}
+
+[[nodiscard]] std::vector<uint32_t> AcquirePixels(size_t size) {
+	auto &pool = PixelsPool();
+	auto result = std::vector<uint32_t>();
+	if (!pool.empty()) {
+		result = std::move(pool.back());
+		pool.pop_back();
+	}
+	result.assign(size, 0);
+	return result;
+}
+
+void ReleasePixels(std::vector<uint32_t> &&buffer) {
+	if (buffer.capacity()) {
+		PixelsPool().push_back(std::move(buffer));
+	}
+}
+
+[[nodiscard]] MatteOperation ToMatteOperation(Canvas::MatteMode mode) {
+	switch (mode) {
+	case Canvas::MatteMode::InvertedAlpha: return MatteOperation::InvertedAlpha;
+	case Canvas::MatteMode::Luma: return MatteOperation::Luma;
+	case Canvas::MatteMode::InvertedLuma: return MatteOperation::InvertedLuma;
+	default: return MatteOperation::Alpha;
+	}
+}
+
+[[nodiscard]] MaskOperation ToMaskOperation(Canvas::MaskMode mode) {
+	switch (mode) {
+	case Canvas::MaskMode::Subtract: return MaskOperation::Subtract;
+	case Canvas::MaskMode::Intersect: return MaskOperation::Intersect;
+	default: return MaskOperation::Add;
+	}
+}
+
+[[nodiscard]] double ApplySpread(double t, QGradient::Spread spread) {
+	switch (spread) {
+	case QGradient::RepeatSpread: return t - std::floor(t);
+	case QGradient::ReflectSpread: {
+		const auto folded = std::fmod(std::abs(t), 2.);
+		return (folded > 1.) ? (2. - folded) : folded;
+	}
+	default: return std::clamp(t, 0., 1.);
+	}
+}
+
+} // namespace
+
+struct ScanlineCanvas::Paint {
+	enum class Type {
+		Solid,
+		Linear,
+		Radial,
+		Image,
+	};
+	Type type = Type::Solid;
+	uint32_t color = 0;
+
+	// Premultiplied ARGB32, color holds the opacity in the alpha byte.
+	QImage image;
+
+	GradientTable table = { { 0 } };
+	QGradient::Spread spread = QGradient::PadSpread;
+	QTransform inverse;
+	QPointF origin;
+	QPointF direction;
+	double factor = 0.;
+	uint64_t hash = 0;
+
+	void fillTable(const GradientTable &colors, qreal opacity);
+	[[nodiscard]] uint64_t computeHash() const;
+	void fetch(int x, int y, int count, uint32_t *colors) const;
+	void fetchImage(int x, int y, int count, uint32_t *colors) const;
+};
+
+void ScanlineCanvas::Paint::fillTable(
+		const GradientTable &colors,
+		qreal opacity) {
+	const auto alpha = uint32_t(std::lround(opacity * 255.));
+	if (alpha == 255) {
+		table = colors;
+		return;
+	}
+	for (auto i = 0; i != kGradientTableSize; ++i) {
+		table[i] = ScalePixel(colors[i], alpha);
+	}
+}
+
+uint64_t ScanlineCanvas::Paint::computeHash() const {
+	const double values[] = {
+		double(type),
+		double(spread),
+		inverse.m11(),
+		inverse.m12(),
+		inverse.m21(),
+		inverse.m22(),
+		inverse.dx(),
+		inverse.dy(),
+		origin.x(),
+		origin.y(),
+		direction.x(),
+		direction.y(),
+		factor,
+	};
+	const auto result = HashBytes(0, values, sizeof(values));
+	return HashBytes(result, table.data(), sizeof(table));
+}
+
+void ScanlineCanvas::Paint::fetch(
+		int x,
+		int y,
+		int count,
+		uint32_t *colors) const {
+	if (type == Type::Image) {
+		fetchImage(x, y, count, colors);
+		return;
+	}
+
+	// Each pixel is mapped on its own, so that redrawing only a part
+	// of a span gives exactly the same colors.
+	const auto py = y + 0.5;
+	const auto u0 = inverse.m21() * py + inverse.dx() - origin.x();
+	const auto v0 = inverse.m22() * py + inverse.dy() - origin.y();
+	const auto lookup = [&](double t) {
+		const auto index = int(ApplySpread(t, spread)
+			* (kGradientTableSize - 1) + 0.5);
+		return table[std::clamp(index, 0, kGradientTableSize - 1)];
+	};
+	for (auto i = 0; i != count; ++i) {
+		const auto px = x + i + 0.5;
+		const auto u = inverse.m11() * px + u0;
+		const auto v = inverse.m12() * px + v0;
+		if (type == Type::Linear) {
+			colors[i] = lookup(
+				(u * direction.x() + v * direction.y()) * factor);
+			continue;
+		}
+
+		// Find t with the point on the circle around
+		// origin + t * direction of radius t * radius.
+		const auto b = u * direction.x() + v * direction.y();
+		const auto c = u * u + v * v;
+		if (factor < 0.) {
+			colors[i] = lookup(
+				(b - std::sqrt(std::max(b * b - factor * c, 0.))) / factor);
+		} else {
+			colors[i] = lookup((b > 0.) ? (c / (2. * b)) : 0.);
+		}
+	}
+}
+
+void ScanlineCanvas::Paint::fetchImage(
+		int x,
+		int y,
+		int count,
+		uint32_t *colors) const {
+	const auto width = image.width();
+	const auto height = image.height();
+	const auto stride = image.bytesPerLine() / 4;
+	const auto bits = reinterpret_cast<const uint32_t*>(image.constBits());
+	const auto alpha = color >> 24;
+	const auto py = y + 0.5;
+	const auto u0 = inverse.m21() * py + inverse.dx() - 0.5;
+	const auto v0 = inverse.m22() * py + inverse.dy() - 0.5;
+	for (auto i = 0; i != count; ++i) {
+		const auto px = x + i + 0.5;
+		const auto u = inverse.m11() * px + u0;
+		const auto v = inverse.m12() * px + v0;
+		const auto left = int(std::floor(u));
+		const auto top = int(std::floor(v));
+		const auto distx = uint32_t(std::clamp(
+			int((u - left) * 256.), 0, 256));
+		const auto disty = uint32_t(std::clamp(
+			int((v - top) * 256.), 0, 256));
+
+		// Samples outside of the image are clamped to its edges.
+		const auto x1 = std::clamp(left, 0, width - 1);
+		const auto x2 = std::clamp(left + 1, 0, width - 1);
+		const auto row1 = bits
+			+ size_t(std::clamp(top, 0, height - 1)) * stride;
+		const auto row2 = bits
+			+ size_t(std::clamp(top + 1, 0, height - 1)) * stride;
+		const auto upper = InterpolatePixel256(
+			row1[x1],
+			256 - distx,
+			row1[x2],
+			distx);
+		const auto lower = InterpolatePixel256(
+			row2[x1],
+			256 - distx,
+			row2[x2],
+			distx);
+		const auto result = InterpolatePixel256(
+			upper,
+			256 - disty,
+			lower,
+			disty);
+		colors[i] = (alpha == 255) ? result : ScalePixel(result, alpha);
+	}
+}
+
+// Coverage of the clip bounds intersected with the band rect.
+struct ScanlineCanvas::ClipCoverage {
+	std::shared_ptr<const Clip> clip;
+	QRect rect;
+	std::vector<uint8_t> values;
+
+	[[nodiscard]] const uint8_t *at(int x, int y) const {
+		return values.data()
+			+ size_t(y - rect.y()) * rect.width()
+			+ (x - rect.x());
+	}
+};
+
+struct ScanlineCanvas::Band {
+	int top = 0;
+	int bottom = 0;
+	int left = 0;
+	int right = 0;
+
+	// Recently used clips of this band, the last one used most recently.
+	std::vector<ClipCoverage> clips;
+
+	std::vector<uint8_t> coverage;
+	std::vector<uint32_t> colors;
+
+	// Offscreen layers of the band rect, for track mattes.
+	struct Layer {
+		std::vector<uint32_t> pixels;
+		std::vector<uint32_t> matte;
+		MatteMode mode = MatteMode::Alpha;
+	};
+	std::vector<Layer> layers;
+	std::vector<uint32_t> matte;
+
+	~Band() {
+		for (auto &clip : clips) {
+			ReleaseCoverage(std::move(clip.values));
+		}
+		ReleasePixels(std::move(matte));
+		for (auto &layer : layers) {
+			ReleasePixels(std::move(layer.pixels));
+			ReleasePixels(std::move(layer.matte));
+		}
+	}
+};
+
+void ScanlineHistory::reset() {
+	_segments.clear();
+	_bits = nullptr;
+	_size = QSize();
+}
+
+ScanlineCanvas::ScanlineCanvas(
+	QImage *image,
+	Mode mode,
+	ScanlineHistory *history,
+	StrokeCache *strokes)
+: _mode(mode)
+, _history(history)
+, _strokes(strokes)
+, _band(std::make_unique<Band>()) {
+	if (image->format() != QImage::Format_ARGB32_Premultiplied) {
+		qWarning() << "ScanlineCanvas:"
+			<< "Only premultiplied ARGB32 images are supported";
+		return;
+	}
+	_bits = reinterpret_cast<uint32_t*>(image->bits());
+	_width = image->width();
+	_height = image->height();
+	_stride = image->bytesPerLine() / 4;
+	_band->bottom = _height;
+	_band->right = _width;
+	_damage = QRect(0, 0, _width, _height);
+}
+
+ScanlineCanvas::~ScanlineCanvas() {
+	finish();
+}
+
+void ScanlineCanvas::finish() {
+	if (_finished || !_bits) {
+		return;
+	}
+	_finished = true;
+	if (!_history) {
+		replay(_damage, false);
+		_operations.clear();
+		return;
+	}
+	_damage = computeDamage();
+	replay(_damage, true);
+
+	_history->_segments.clear();
+	_history->_segments.reserve(_operations.size());
+	for (const auto &operation : _operations) {
+		_history->_segments.push_back({ operation.hash, operation.bounds });
+	}
+	_history->_bits = _bits;
+	_history->_size = size();
+	_operations.clear();
+}
+
+const QRegion &ScanlineCanvas::damage() const {
+	return _damage;
+}
+
+// Pixels outside of the damage are covered by the same operations in the
+// same order as in the previous frame. Operations are matched by hash in
+// the order of the previous frame, the ones that are new, gone or drawn
+// in a different order damage their bounds.
+QRegion ScanlineCanvas::computeDamage() const {
+	const auto full = QRect(0, 0, _width, _height);
+	if (_history->_bits != _bits || _history->_size != size()) {
+		return full;
+	}
+	const auto &previous = _history->_segments;
+	auto available = std::unordered_map<uint64_t, std::vector<int>>();
+	for (auto i = int(previous.size()); i != 0;) {
+		--i;
+		available[previous[i].hash].push_back(i);
+	}
+	auto matched = std::vector<bool>(previous.size(), false);
+	auto result = QRegion();
+	auto last = -1;
+	for (const auto &operation : _operations) {
+		const auto i = available.find(operation.hash);
+		if (i != end(available) && !i->second.empty()) {
+			const auto index = i->second.back();
+			i->second.pop_back();
+			matched[index] = true;
+			if (index > last) {
+				last = index;
+				continue;
+			}
+			result += previous[index].bounds;
+		}
+		result += operation.bounds;
+	}
+	for (auto i = 0, count = int(previous.size()); i != count; ++i) {
+		if (!matched[i]) {
+			result += previous[i].bounds;
+		}
+	}
+	return result.intersected(full);
+}
+
+void ScanlineCanvas::replay(const QRegion &region, bool clear) {
+	if (_operations.empty() && !clear) {
+		return;
+	}
+	auto bands = std::vector<QRect>();
+	for (const auto &rect : region) {
+		for (auto top = rect.y(); top < rect.y() + rect.height();) {
+			const auto height = std::min(
+				kBandHeight,
+				rect.y() + rect.height() - top);
+			bands.push_back(QRect(rect.x(), top, rect.width(), height));
+			top += height;
+		}
+	}
+	const auto method = [&](int index) {
+		const auto &rect = bands[index];
+		auto band = Band();
+		band.top = rect.y();
+		band.bottom = rect.y() + rect.height();
+		band.left = rect.x();
+		band.right = rect.x() + rect.width();
+		if (clear) {
+			for (auto y = band.top; y != band.bottom; ++y) {
+				memset(
+					_bits + size_t(y) * _stride + band.left,
+					0,
+					size_t(band.right - band.left) * sizeof(uint32_t));
+			}
+		}
+		for (const auto &operation : _operations) {
+			replay(operation, band);
+		}
+	};
+	if (_mode == Mode::Parallel) {
+		ParallelFor(int(bands.size()), method);
+	} else {
+		for (auto i = 0, count = int(bands.size()); i != count; ++i) {
+			method(i);
+		}
+	}
+}
+
+QSize ScanlineCanvas::size() const {
+	return QSize(_width, _height);
+}
+
+void ScanlineCanvas::save() {
+	_stack.push_back(_state);
+}
+
+void ScanlineCanvas::restore() {
+	if (!_stack.empty()) {
+		_state = std::move(_stack.back());
+		_stack.pop_back();
+	}
+}
+
+QTransform ScanlineCanvas::transform() const {
+	return _state.transform;
+}
+
+void ScanlineCanvas::setTransform(const QTransform &transform) {
+	_state.transform = transform;
+}
+
+qreal ScanlineCanvas::opacity() const {
+	return _state.opacity;
+}
+
+void ScanlineCanvas::setOpacity(qreal opacity) {
+	_state.opacity = std::clamp(opacity, 0., 1.);
+}
+
+void ScanlineCanvas::setBrush(const QBrush &brush) {
+	_state.brush = brush;
+	_state.table = nullptr;
+}
+
+void ScanlineCanvas::setGradientBrush(
+		const QBrush &brush,
+		std::shared_ptr<const GradientTable> table) {
+	_state.brush = brush;
+	_state.table = std::move(table);
+}
+
+void ScanlineCanvas::setPen(const QPen &pen) {
+	_state.pen = pen;
+}
+
+void ScanlineCanvas::drawPath(const QPainterPath &path) {
+	paintPath(path, nullptr);
+}
+
+void ScanlineCanvas::drawPathInstances(
+		const QPainterPath &path,
+		const std::vector<Instance> &instances) {
+	if (!_bits || path.isEmpty()) {
+		return;
+	}
+	const auto &pen = _state.pen;
+	auto outline = std::optional<QPainterPath>();
+	const auto saved = std::make_pair(_state.transform, _state.opacity);
+	for (const auto &instance : instances) {
+		_state.transform = instance.transform;
+		_state.opacity = instance.opacity;
+		if (instance.opacity <= 0. || tooSmall(path)) {
+			continue;
+		} else if (!outline && pen.style() != Qt::NoPen && !pen.isCosmetic()) {
+			outline = strokeOutline(path);
+		}
+		paintPath(path, outline ? &*outline : nullptr);
+	}
+	_state.transform = saved.first;
+	_state.opacity = saved.second;
+}
+
+QPainterPath ScanlineCanvas::strokeOutline(const QPainterPath &path) const {
+	return _strokes
+		? _strokes->outline(path, _state.pen)
+		: QPainterPathStroker(_state.pen).createStroke(path);
+}
+
+bool ScanlineCanvas::tooSmall(const QPainterPath &path) const {
+	const auto &pen = _state.pen;
+	const auto &transform = _state.transform;
+	const auto scale = pen.isCosmetic() ? 1. : std::max(
+		std::hypot(transform.m11(), transform.m12()),
+		std::hypot(transform.m21(), transform.m22()));
+	const auto stroke = 2. * BMStroke::Extent(pen) * scale;
+	const auto rect = transform.mapRect(path.controlPointRect());
+	return (rect.width() + stroke < kMinPathSize)
+		&& (rect.height() + stroke < kMinPathSize);
+}
+
+void ScanlineCanvas::paintPath(
+		const QPainterPath &path,
+		const QPainterPath *outline) {
+	if (!_bits || _state.opacity <= 0. || path.isEmpty()) {
+		return;
+	} else if (tooSmall(path)) {
+		return;
+	}
+	if (auto paint = preparePaint(
+			_state.brush,
+			_state.table.get(),
+			_state.transform)) {
+		fill(path, _state.transform, (path.fillRule() == Qt::WindingFill)
+			? ScanlineRasterizer::FillRule::NonZero
+			: ScanlineRasterizer::FillRule::EvenOdd, std::move(paint));
+	}
+	const auto &pen = _state.pen;
+	if (pen.style() == Qt::NoPen) {
+		return;
+	} else if (auto paint = preparePaint(
+			pen.brush(),
+			nullptr,
+			_state.transform)) {
+		if (pen.isCosmetic()) {
+			auto stroker = QPainterPathStroker(pen);
+			if (pen.widthF() <= 0.) {
+				stroker.setWidth(1.);
+			}
+			fill(
+				stroker.createStroke(_state.transform.map(path)),
+				QTransform(),
+				ScanlineRasterizer::FillRule::NonZero,
+				std::move(paint));
+		} else {
+			fill(
+				outline ? *outline : strokeOutline(path),
+				_state.transform,
+				ScanlineRasterizer::FillRule::NonZero,
+				std::move(paint));
+		}
+	}
+}
+
+void ScanlineCanvas::drawImage(const QRectF &target, const QImage &image) {
+	if (!_bits
+		|| _state.opacity <= 0.
+		|| target.isEmpty()
+		|| image.isNull()) {
+		return;
+	} else if (image.format() != QImage::Format_ARGB32_Premultiplied) {
+		qWarning() << "ScanlineCanvas:"
+			<< "Only premultiplied ARGB32 images can be drawn";
+		return;
+	}
+	const auto placement = QTransform::fromTranslate(
+		target.x(),
+		target.y()
+	).scale(
+		target.width() / image.width(),
+		target.height() / image.height());
+	auto invertible = false;
+	const auto inverse = (placement * _state.transform).inverted(&invertible);
+	if (!invertible) {
+		return;
+	}
+	auto paint = std::make_shared<Paint>();
+	paint->type = Paint::Type::Image;
+	paint->image = image;
+	paint->inverse = inverse;
+	paint->color = uint32_t(std::lround(_state.opacity * 255.)) << 24;
+	const auto key = image.cacheKey();
+	paint->hash = HashBytes(paint->computeHash(), &key, sizeof(key));
+	paint->hash = HashBytes(paint->hash, &paint->color, sizeof(paint->color));
+
+	auto path = QPainterPath();
+	path.addRect(target);
+	fill(
+		path,
+		_state.transform,
+		ScanlineRasterizer::FillRule::NonZero,
+		std::move(paint));
+}
+
+void ScanlineCanvas::setClipPath(const QPainterPath &path) {
+	auto clip = std::make_shared<Clip>();
+	addClipItem(*clip, path, MaskMode::Add, false, 1.);
+	finishClip(*clip);
+	_state.clip = std::move(clip);
+}
+
+void ScanlineCanvas::addMask(
+		const QPainterPath &path,
+		MaskMode mode,
+		bool inverted,
+		qreal opacity) {
+	if (!_mask) {
+		_mask = std::make_shared<Clip>();
+		_mask->startFull = (mode != MaskMode::Add);
+	}
+	addClipItem(*_mask, path, mode, inverted, opacity);
+}
+
+void ScanlineCanvas::applyMask() {
+	if (!_mask) {
+		return;
+	}
+	_mask->parent = _state.clip;
+	finishClip(*_mask);
+	_state.clip = std::move(_mask);
+}
+
+void ScanlineCanvas::addClipItem(
+		Clip &clip,
+		const QPainterPath &path,
+		MaskMode mode,
+		bool inverted,
+		qreal opacity) const {
+	clip.items.emplace_back();
+	auto &item = clip.items.back();
+	rasterize(item.shape, path, _state.transform);
+	item.rule = (path.fillRule() == Qt::WindingFill)
+		? ScanlineRasterizer::FillRule::NonZero
+		: ScanlineRasterizer::FillRule::EvenOdd;
+	item.mode = mode;
+	item.inverted = inverted;
+	item.alpha = uint8_t(std::lround(std::clamp(opacity, 0., 1.) * 255.));
+}
+
+// Bounds are conservative: everything outside of them is fully clipped.
+void ScanlineCanvas::finishClip(Clip &clip) const {
+	const auto full = QRect(0, 0, _width, _height);
+	auto bounds = clip.startFull ? full : QRect();
+	auto hash = HashBytes(0, &clip.startFull, sizeof(clip.startFull));
+	for (const auto &item : clip.items) {
+		const auto &shape = item.shape;
+		const auto itemBounds = item.inverted
+			? full
+			: QRect(
+				shape.left(),
+				shape.top(),
+				shape.right() - shape.left(),
+				shape.bottom() - shape.top());
+		switch (item.mode) {
+		case MaskMode::Add: bounds |= itemBounds; break;
+		case MaskMode::Subtract: break;
+		case MaskMode::Intersect: bounds &= itemBounds; break;
+		}
+		const auto shapeHash = shape.hash();
+		hash = HashBytes(hash, &shapeHash, sizeof(shapeHash));
+		hash = HashBytes(hash, &item.rule, sizeof(item.rule));
+		hash = HashBytes(hash, &item.mode, sizeof(item.mode));
+		hash = HashBytes(hash, &item.inverted, sizeof(item.inverted));
+		hash = HashBytes(hash, &item.alpha, sizeof(item.alpha));
+	}
+	if (const auto parent = clip.parent.get()) {
+		bounds &= parent->bounds;
+		hash = HashBytes(hash, &parent->hash, sizeof(parent->hash));
+	}
+	clip.bounds = bounds;
+	clip.hash = hash;
+}
+
+auto ScanlineCanvas::clipCoverage(
+		const std::shared_ptr<const Clip> &clip,
+		Band &band) const -> const ClipCoverage & {
+	auto &clips = band.clips;
+	const auto i = std::find_if(begin(clips), end(clips), [&](
+			const ClipCoverage &entry) {
+		return (entry.clip == clip);
+	});
+	if (i != end(clips)) {
+		std::rotate(i, i + 1, end(clips));
+		return clips.back();
+	}
+	auto rendered = renderClip(clip, band);
+	if (int(clips.size()) >= kMaxBandClips) {
+		ReleaseCoverage(std::move(clips.front().values));
+		clips.erase(begin(clips));
+	}
+	clips.push_back(std::move(rendered));
+	return clips.back();
+}
+
+// Masks inside masks share the coverage of their parents in the band,
+// so the work for each clip is limited to its bounds.
+auto ScanlineCanvas::renderClip(
+		const std::shared_ptr<const Clip> &clip,
+		Band &band) const -> ClipCoverage {
+	auto result = ClipCoverage{ clip };
+	result.rect = clip->bounds.intersected(QRect(
+		band.left,
+		band.top,
+		band.right - band.left,
+		band.bottom - band.top));
+	result.values = AcquireCoverage();
+	if (result.rect.isEmpty()) {
+		result.values.clear();
+		return result;
+	}
+	const auto &rect = result.rect;
+	const auto width = rect.width();
+	const auto size = size_t(rect.height()) * width;
+	result.values.assign(size, clip->startFull ? 255 : 0);
+	auto coverage = AcquireCoverage();
+	for (const auto &item : clip->items) {
+		coverage.assign(size, 0);
+		item.shape.render(
+			item.rule,
+			rect.y(),
+			rect.y() + rect.height(),
+			[&](int y, int x, int count, const uint8_t *row) {
+				const auto from = std::max(x, rect.x());
+				const auto till = std::min(x + count, rect.x() + width);
+				if (from < till) {
+					memcpy(
+						coverage.data()
+							+ size_t(y - rect.y()) * width
+							+ (from - rect.x()),
+						row + (from - x),
+						till - from);
+				}
+			});
+		CombineMask(
+			result.values.data(),
+			int(size),
+			coverage.data(),
+			ToMaskOperation(item.mode),
+			item.inverted,
+			item.alpha);
+	}
+	ReleaseCoverage(std::move(coverage));
+
+	// The clip bounds are inside of the parent bounds, see finishClip().
+	if (clip->parent) {
+		const auto &parent = clipCoverage(clip->parent, band);
+		for (auto y = rect.y(); y != rect.y() + rect.height(); ++y) {
+			MultiplyCoverage(
+				result.values.data() + size_t(y - rect.y()) * width,
+				width,
+				parent.at(rect.x(), y));
+		}
+	}
+	return result;
+}
+
+void ScanlineCanvas::rasterize(
+		ScanlineRasterizer &rasterizer,
+		const QPainterPath &path,
+		const QTransform &transform) const {
+	rasterizer.reset(_width, _height);
+	const auto map = [&](const QPainterPath::Element &element) {
+		return transform.map(QPointF(element.x, element.y));
+	};
+	for (auto i = 0, count = path.elementCount(); i != count; ++i) {
+		const auto &element = path.elementAt(i);
+		switch (element.type) {
+		case QPainterPath::MoveToElement: {
+			const auto point = map(element);
+			rasterizer.moveTo(point.x(), point.y());
+		} break;
+		case QPainterPath::LineToElement: {
+			const auto point = map(element);
+			rasterizer.lineTo(point.x(), point.y());
+		} break;
+		case QPainterPath::CurveToElement: {
+			if (i + 2 >= count) {
+				break;
+			}
+			const auto first = map(element);
+			const auto second = map(path.elementAt(i + 1));
+			const auto end = map(path.elementAt(i + 2));
+			rasterizer.cubicTo(
+				first.x(),
+				first.y(),
+				second.x(),
+				second.y(),
+				end.x(),
+				end.y());
+			i += 2;
+		} break;
+		default: break;
+		}
+	}
+	rasterizer.finish();
+}
+
+void ScanlineCanvas::fill(
+		const QPainterPath &path,
+		const QTransform &transform,
+		ScanlineRasterizer::FillRule rule,
+		std::shared_ptr<const Paint> paint) {
+	auto shape = std::make_shared<ScanlineRasterizer>();
+	rasterize(*shape, path, transform);
+	if (shape->empty()) {
+		return;
+	}
+	auto operation = Operation{
+		std::move(shape),
+		rule,
+		std::move(paint),
+		_state.clip,
+	};
+	const auto &recorded = *operation.shape;
+	operation.bounds = QRect(
+		recorded.left(),
+		recorded.top(),
+		recorded.right() - recorded.left(),
+		recorded.bottom() - recorded.top());
+	operation.hash = HashBytes(
+		recorded.hash(),
+		&operation.paint->hash,
+		sizeof(operation.paint->hash));
+	operation.hash = HashBytes(operation.hash, &rule, sizeof(rule));
+	if (const auto clip = operation.clip.get()) {
+		operation.bounds &= clip->bounds;
+		operation.hash = HashBytes(
+			operation.hash,
+			&clip->hash,
+			sizeof(clip->hash));
+	}
+	if (!operation.bounds.isEmpty()) {
+		record(std::move(operation));
+	}
+}
+
+void ScanlineCanvas::beginMatteLayer() {
+	recordLayer(OperationType::BeginMatteLayer);
+}
+
+void ScanlineCanvas::endMatteLayer() {
+	recordLayer(OperationType::EndMatteLayer);
+}
+
+void ScanlineCanvas::beginMattedLayer(MatteMode mode) {
+	recordLayer(OperationType::BeginMattedLayer, mode);
+}
+
+void ScanlineCanvas::endMattedLayer() {
+	recordLayer(OperationType::EndMattedLayer);
+}
+
+// Layer operations change what every pixel means, so their bounds are
+// the whole canvas for the damage tracking.
+void ScanlineCanvas::recordLayer(OperationType type, MatteMode matte) {
+	if (!_bits) {
+		return;
+	}
+	auto operation = Operation();
+	operation.type = type;
+	operation.matte = matte;
+	operation.bounds = QRect(0, 0, _width, _height);
+	operation.hash = HashBytes(
+		HashBytes(0, &type, sizeof(type)),
+		&matte,
+		sizeof(matte));
+	record(std::move(operation));
+}
+
+void ScanlineCanvas::record(Operation &&operation) {
+	if (_mode == Mode::Parallel || _history) {
+		_operations.push_back(std::move(operation));
+	} else {
+		replay(operation, *_band);
+	}
+}
+
+void ScanlineCanvas::replay(const Operation &operation, Band &band) const {
+	if (operation.type == OperationType::Fill) {
+		replayFill(operation, band);
+	} else {
+		replayLayer(operation, band);
+	}
+}
+
+uint32_t *ScanlineCanvas::target(Band &band, int x, int y) const {
+	if (band.layers.empty()) {
+		return _bits + size_t(y) * _stride + x;
+	}
+	const auto stride = band.right - band.left;
+	return band.layers.back().pixels.data()
+		+ size_t(y - band.top) * stride
+		+ (x - band.left);
+}
+
+void ScanlineCanvas::replayLayer(
+		const Operation &operation,
+		Band &band) const {
+	const auto stride = band.right - band.left;
+	const auto size = size_t(band.bottom - band.top) * stride;
+	switch (operation.type) {
+	case OperationType::BeginMatteLayer:
+		band.layers.push_back({ AcquirePixels(size) });
+		break;
+	case OperationType::EndMatteLayer:
+		if (!band.layers.empty()) {
+			ReleasePixels(std::move(band.matte));
+			band.matte = std::move(band.layers.back().pixels);
+			ReleasePixels(std::move(band.layers.back().matte));
+			band.layers.pop_back();
+		}
+		break;
+	case OperationType::BeginMattedLayer:
+		band.layers.push_back({
+			AcquirePixels(size),
+			std::exchange(band.matte, std::vector<uint32_t>()),
+			operation.matte,
+		});
+		break;
+	case OperationType::EndMattedLayer: {
+		if (band.layers.empty()) {
+			break;
+		}
+		auto layer = std::move(band.layers.back());
+		band.layers.pop_back();
+
+		// A missing matte is transparent.
+		const auto mode = ToMatteOperation(layer.mode);
+		const auto inverted = (mode == MatteOperation::InvertedAlpha)
+			|| (mode == MatteOperation::InvertedLuma);
+		band.coverage.assign(stride, inverted ? 255 : 0);
+		for (auto y = band.top; y != band.bottom; ++y) {
+			const auto offset = size_t(y - band.top) * stride;
+			if (!layer.matte.empty()) {
+				MatteCoverage(
+					band.coverage.data(),
+					stride,
+					layer.matte.data() + offset,
+					mode);
+			}
+			BlendBufferSpan(
+				target(band, band.left, y),
+				stride,
+				band.coverage.data(),
+				layer.pixels.data() + offset);
+		}
+		ReleasePixels(std::move(layer.pixels));
+		ReleasePixels(std::move(layer.matte));
+	} break;
+	default: break;
+	}
+}
+
+void ScanlineCanvas::replayFill(
+		const Operation &operation,
+		Band &band) const {
+	const auto &shape = *operation.shape;
+	const auto clip = operation.clip.get();
+	const auto &bounds = operation.bounds;
+	const auto from = std::max(band.top, bounds.y());
+	const auto till = std::min(band.bottom, bounds.y() + bounds.height());
+	const auto left = std::max(band.left, bounds.x());
+	const auto right = std::min(band.right, bounds.x() + bounds.width());
+	if (from >= till || left >= right) {
+		return;
+	}
+	const auto clipped = clip
+		? &clipCoverage(operation.clip, band)
+		: nullptr;
+	const auto &paint = *operation.paint;
+	band.coverage.resize(_width);
+	band.colors.resize(_width);
+	shape.render(operation.rule, from, till, [&](
+			int y,
+			int x,
+			int count,
+			const uint8_t *coverage) {
+		if (x < left) {
+			coverage += left - x;
+			count -= left - x;
+			x = left;
+		}
+		count = std::min(count, right - x);
+		if (count <= 0) {
+			return;
+		}
+		if (clipped) {
+			memcpy(band.coverage.data(), coverage, count);
+			MultiplyCoverage(band.coverage.data(), count, clipped->at(x, y));
+			coverage = band.coverage.data();
+		}
+		const auto dst = target(band, x, y);
+		if (paint.type == Paint::Type::Solid) {
+			BlendSolidSpan(dst, count, coverage, paint.color);
+		} else {
+			paint.fetch(x, y, count, band.colors.data());
+			BlendBufferSpan(dst, count, coverage, band.colors.data());
+		}
+	});
+}
+
+auto ScanlineCanvas::preparePaint(
+		const QBrush &brush,
+		const GradientTable *table,
+		const QTransform &transform) const -> std::shared_ptr<const Paint> {
+	const auto style = brush.style();
+	if (style == Qt::NoBrush) {
+		return nullptr;
+	}
+	auto result = std::make_shared<Paint>();
+	auto &paint = *result;
+	if (style != Qt::LinearGradientPattern
+		&& style != Qt::RadialGradientPattern) {
+		paint.type = Paint::Type::Solid;
+		paint.color = SolidColor(brush.color(), _state.opacity);
+		paint.hash = HashBytes(0, &paint.color, sizeof(paint.color));
+		return paint.color ? result : nullptr;
+	}
+	const auto gradient = brush.gradient();
+	if (!gradient) {
+		return nullptr;
+	}
+	auto invertible = false;
+	paint.inverse = (brush.transform() * transform).inverted(&invertible);
+	if (!invertible) {
+		return nullptr;
+	}
+	paint.spread = gradient->spread();
+	paint.fillTable(
+		table ? *table : BuildGradientTable(gradient->stops()),
+		_state.opacity);
+	if (style == Qt::LinearGradientPattern) {
+		const auto linear = static_cast<const QLinearGradient*>(gradient);
+		const auto delta = linear->finalStop() - linear->start();
+		const auto length = QPointF::dotProduct(delta, delta);
+		paint.type = Paint::Type::Linear;
+		paint.origin = linear->start();
+		paint.direction = delta;
+		paint.factor = (length > 0.) ? (1. / length) : 0.;
+	} else {
+		const auto radial = static_cast<const QRadialGradient*>(gradient);
+		const auto radius = radial->centerRadius();
+		auto delta = radial->center() - radial->focalPoint();
+		const auto distance = std::sqrt(QPointF::dotProduct(delta, delta));
+		if (distance > radius * kMaxFocalDistance && distance > 0.) {
+			delta *= radius * kMaxFocalDistance / distance;
+		}
+		paint.type = Paint::Type::Radial;
+		paint.origin = radial->center() - delta;
+		paint.direction = delta;
+		paint.factor = QPointF::dotProduct(delta, delta) - radius * radius;
+	}
+	paint.hash = paint.computeHash();
+	return result;
+}
+
+} // namespace Lottie
@@ -0,0 +1,219 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "canvas.h"
+#include "scanlinerasterizer.h"
+
+#include <QTransform>
+#include <QBrush>
+#include <QPen>
+#include <QRegion>
+
+#include <memory>
+#include <vector>
+
+class QImage;
+
+namespace Lottie {
+
+class StrokeCache;
+
+// What was drawn into an image by the last ScanlineCanvas, kept between
+// frames so that the next frame repaints only the changed region.
+class ScanlineHistory final {
+public:
+	// Forces the next frame to be drawn completely.
+	void reset();
+
+private:
+	friend class ScanlineCanvas;
+
+	struct Segment {
+		uint64_t hash = 0;
+		QRect bounds;
+	};
+
+	std::vector<Segment> _segments;
+	const void *_bits = nullptr;
+	QSize _size;
+
+};
+
+// Draws into a premultiplied ARGB32 image with the own scanline
+// rasterizer and SIMD span blending instead of QPainter.
+//
+// In Parallel mode draw calls are only recorded and finish() rasterizes
+// them by row bands on the thread pool. Rows are rasterized and blended
+// independently, so the result is bit-identical to the Immediate mode.
+//
+// With a history the image must keep the previous frame: finish()
+// compares each recorded operation with the previous frame and clears
+// and redraws only the region where they differ.
+//
+// With a stroke cache the outlines of strokes are taken from it.
+class ScanlineCanvas final : public Canvas {
+public:
+	enum class Mode {
+		Immediate,
+		Parallel,
+	};
+
+	explicit ScanlineCanvas(
+		QImage *image,
+		Mode mode = Mode::Immediate,
+		ScanlineHistory *history = nullptr,
+		StrokeCache *strokes = nullptr);
+	~ScanlineCanvas();
+
+	// Rasterizes everything recorded in the Parallel mode or with history.
+	void finish();
+
+	// The part of the image changed by finish(), whole image without history.
+	[[nodiscard]] const QRegion &damage() const;
+
+	[[nodiscard]] QSize size() const override;
+
+	void save() override;
+	void restore() override;
+
+	[[nodiscard]] QTransform transform() const override;
+	void setTransform(const QTransform &transform) override;
+
+	[[nodiscard]] qreal opacity() const override;
+	void setOpacity(qreal opacity) override;
+
+	void setBrush(const QBrush &brush) override;
+	void setGradientBrush(
+		const QBrush &brush,
+		std::shared_ptr<const GradientTable> table) override;
+	void setPen(const QPen &pen) override;
+
+	void drawPath(const QPainterPath &path) override;
+	void drawPathInstances(
+		const QPainterPath &path,
+		const std::vector<Instance> &instances) override;
+	void drawImage(const QRectF &target, const QImage &image) override;
+
+	void setClipPath(const QPainterPath &path) override;
+
+	void addMask(
+		const QPainterPath &path,
+		MaskMode mode,
+		bool inverted,
+		qreal opacity) override;
+	void applyMask() override;
+
+	void beginMatteLayer() override;
+	void endMatteLayer() override;
+	void beginMattedLayer(MatteMode mode) override;
+	void endMattedLayer() override;
+
+private:
+	struct Paint;
+	struct Band;
+	struct ClipCoverage;
+
+	// Clips are kept as shapes and get rasterized to 8-bit coverage of
+	// their bounds separately for each band, combined with the parent clip.
+	struct Clip {
+		struct Item {
+			ScanlineRasterizer shape;
+			ScanlineRasterizer::FillRule rule;
+			MaskMode mode = MaskMode::Add;
+			bool inverted = false;
+			uint8_t alpha = 255;
+		};
+		std::vector<Item> items;
+		std::shared_ptr<const Clip> parent;
+		bool startFull = false;
+		QRect bounds;
+		uint64_t hash = 0;
+	};
+	enum class OperationType {
+		Fill,
+		BeginMatteLayer,
+		EndMatteLayer,
+		BeginMattedLayer,
+		EndMattedLayer,
+	};
+	struct Operation {
+		std::shared_ptr<const ScanlineRasterizer> shape;
+		ScanlineRasterizer::FillRule rule;
+		std::shared_ptr<const Paint> paint;
+		std::shared_ptr<const Clip> clip;
+		uint64_t hash = 0;
+		QRect bounds;
+		OperationType type = OperationType::Fill;
+		MatteMode matte = MatteMode::Alpha;
+	};
+	struct State {
+		QTransform transform;
+		qreal opacity = 1.;
+		QBrush brush;
+		std::shared_ptr<const GradientTable> table;
+		QPen pen;
+		std::shared_ptr<const Clip> clip;
+	};
+	// The outline may be given when it was already stroked.
+	void paintPath(const QPainterPath &path, const QPainterPath *outline);
+	[[nodiscard]] QPainterPath strokeOutline(const QPainterPath &path) const;
+	[[nodiscard]] bool tooSmall(const QPainterPath &path) const;
+	void rasterize(
+		ScanlineRasterizer &rasterizer,
+		const QPainterPath &path,
+		const QTransform &transform) const;
+	[[nodiscard]] std::shared_ptr<const Paint> preparePaint(
+		const QBrush &brush,
+		const GradientTable *table,
+		const QTransform &transform) const;
+	void fill(
+		const QPainterPath &path,
+		const QTransform &transform,
+		ScanlineRasterizer::FillRule rule,
+		std::shared_ptr<const Paint> paint);
+	void record(Operation &&operation);
+	void recordLayer(OperationType type, MatteMode matte = MatteMode::Alpha);
+	void replay(const Operation &operation, Band &band) const;
+	void replayFill(const Operation &operation, Band &band) const;
+	void replayLayer(const Operation &operation, Band &band) const;
+	[[nodiscard]] uint32_t *target(Band &band, int x, int y) const;
+	void addClipItem(
+		Clip &clip,
+		const QPainterPath &path,
+		MaskMode mode,
+		bool inverted,
+		qreal opacity) const;
+	void finishClip(Clip &clip) const;
+	[[nodiscard]] const ClipCoverage &clipCoverage(
+		const std::shared_ptr<const Clip> &clip,
+		Band &band) const;
+	[[nodiscard]] ClipCoverage renderClip(
+		const std::shared_ptr<const Clip> &clip,
+		Band &band) const;
+	void replay(const QRegion &region, bool clear);
+	[[nodiscard]] QRegion computeDamage() const;
+
+	uint32_t *_bits = nullptr;
+	int _width = 0;
+	int _height = 0;
+	int _stride = 0;
+	Mode _mode = Mode::Immediate;
+	ScanlineHistory *_history = nullptr;
+	StrokeCache *_strokes = nullptr;
+	QRegion _damage;
+	bool _finished = false;
+	State _state;
+	std::vector<State> _stack;
+	std::vector<Operation> _operations;
+	std::shared_ptr<Clip> _mask;
+	std::unique_ptr<Band> _band;
+
+};
+
+} // namespace Lottie
@@ -0,0 +1,419 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "scanlinerasterizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace Lottie {
+namespace {
+
+// Maximum distance in pixels between a curve and its flattening.
+constexpr auto kTolerance = 0.2;
+constexpr auto kMaxCurveSegments = 256;
+constexpr auto kHashSeed = uint64_t(14695981039346656037ULL);
+constexpr auto kHashPrime = uint64_t(1099511628211ULL);
+
+} // namespace
+
+uint64_t HashBytes(uint64_t seed, const void *data, std::size_t size) {
+	auto bytes = static_cast<const uint8_t*>(data);
+	for (const auto till = bytes + size; bytes != till; ++bytes) {
+		seed = (seed ^ *bytes) * kHashPrime;
+	}
+	return seed;
+}
+
+struct ScanlineRasterizer::Buffers {
+	std::vector<float> cells;
+	std::vector<uint8_t> coverage;
+	std::vector<const Edge*> active;
+};
+
+// Scratch memory of render(), so that it can run on pool threads.
+ScanlineRasterizer::Buffers &ScanlineRasterizer::ThreadBuffers() {
+	thread_local auto result = Buffers();
+	return result;
+}
+
+void ScanlineRasterizer::reset(int width, int height) {
+	_width = std::max(width, 0);
+	_height = std::max(height, 0);
+	_edges.clear();
+	_top = _bottom = _left = _right = 0;
+	_hash = 0;
+	_clippedRight = false;
+	_finished = false;
+	_hasSubpath = false;
+}
+
+void ScanlineRasterizer::moveTo(double x, double y) {
+	close();
+	_startX = _lastX = x;
+	_startY = _lastY = y;
+	_hasSubpath = true;
+}
+
+void ScanlineRasterizer::lineTo(double x, double y) {
+	if (!_hasSubpath) {
+		moveTo(x, y);
+		return;
+	}
+	addEdge(_lastX, _lastY, x, y);
+	_lastX = x;
+	_lastY = y;
+}
+
+void ScanlineRasterizer::cubicTo(
+		double x1,
+		double y1,
+		double x2,
+		double y2,
+		double x3,
+		double y3) {
+	if (!_hasSubpath) {
+		moveTo(_lastX, _lastY);
+	}
+	const auto x0 = _lastX;
+	const auto y0 = _lastY;
+
+	// Wang's formula: the flattening error of n uniform segments is
+	// bounded by 3/4 * max |P[i] - 2 P[i+1] + P[i+2]| / n^2.
+	const auto ddx1 = x0 - 2. * x1 + x2;
+	const auto ddy1 = y0 - 2. * y1 + y2;
+	const auto ddx2 = x1 - 2. * x2 + x3;
+	const auto ddy2 = y1 - 2. * y2 + y3;
+	const auto dd = std::sqrt(std::max(
+		ddx1 * ddx1 + ddy1 * ddy1,
+		ddx2 * ddx2 + ddy2 * ddy2));
+	const auto wanted = std::ceil(std::sqrt(0.75 * dd / kTolerance));
+	const auto segments = std::isfinite(wanted)
+		? std::clamp(int(wanted), 1, kMaxCurveSegments)
+		: 1;
+	for (auto i = 1; i < segments; ++i) {
+		const auto t = double(i) / segments;
+		const auto u = 1. - t;
+		const auto b0 = u * u * u;
+		const auto b1 = 3. * u * u * t;
+		const auto b2 = 3. * u * t * t;
+		const auto b3 = t * t * t;
+		lineTo(
+			b0 * x0 + b1 * x1 + b2 * x2 + b3 * x3,
+			b0 * y0 + b1 * y1 + b2 * y2 + b3 * y3);
+	}
+	lineTo(x3, y3);
+}
+
+void ScanlineRasterizer::close() {
+	if (_hasSubpath) {
+		addEdge(_lastX, _lastY, _startX, _startY);
+		_lastX = _startX;
+		_lastY = _startY;
+	}
+}
+
+void ScanlineRasterizer::finish() {
+	if (_finished) {
+		return;
+	}
+	close();
+	_hasSubpath = false;
+	std::stable_sort(begin(_edges), end(_edges), [](
+			const Edge &a,
+			const Edge &b) {
+		return a.topRow < b.topRow;
+	});
+	_top = _height;
+	_bottom = 0;
+	_left = _width;
+	_right = 0;
+	_hash = kHashSeed;
+	const auto add = [&](const auto &value) {
+		_hash = HashBytes(_hash, &value, sizeof(value));
+	};
+	for (const auto &edge : _edges) {
+		_top = std::min(_top, edge.topRow);
+		_bottom = std::max(_bottom, edge.bottomRow);
+		_left = std::min(_left, int(std::floor(std::min(edge.x0, edge.x1))));
+		_right = std::max(
+			_right,
+			int(std::ceil(std::max(edge.x0, edge.x1))) + 2);
+		add(edge.x0);
+		add(edge.y0);
+		add(edge.x1);
+		add(edge.y1);
+		add(edge.direction);
+	}
+	if (_clippedRight) {
+		_right = _width;
+	}
+	_left = std::clamp(_left, 0, _width);
+	_right = std::clamp(_right, _left, _width);
+	if (_top >= _bottom || _left >= _right) {
+		_top = _bottom = _left = _right = 0;
+	}
+	_finished = true;
+}
+
+bool ScanlineRasterizer::empty() const {
+	return _edges.empty();
+}
+
+int ScanlineRasterizer::top() const {
+	return _top;
+}
+
+int ScanlineRasterizer::bottom() const {
+	return _bottom;
+}
+
+int ScanlineRasterizer::left() const {
+	return _left;
+}
+
+int ScanlineRasterizer::right() const {
+	return _right;
+}
+
+uint64_t ScanlineRasterizer::hash() const {
+	return _hash;
+}
+
+void ScanlineRasterizer::addEdge(double x0, double y0, double x1, double y1) {
+	if (y0 == y1
+		|| !std::isfinite(x0)
+		|| !std::isfinite(y0)
+		|| !std::isfinite(x1)
+		|| !std::isfinite(y1)) {
+		return;
+	}
+	const auto width = double(_width);
+
+	// Parts to the right of the canvas never change visible pixels and
+	// parts to the left are projected onto the left border.
+	const auto split = [&](double bound, double &x, double &y) {
+		y = y0 + (bound - x0) * (y1 - y0) / (x1 - x0);
+		x = bound;
+	};
+	if (x0 >= width || x1 >= width) {
+		_clippedRight = true;
+	}
+	if (x0 >= width && x1 >= width) {
+		return;
+	} else if (x0 > width || x1 > width) {
+		auto x = 0., y = 0.;
+		split(width, x, y);
+		if (x0 > width) {
+			x0 = x;
+			y0 = y;
+		} else {
+			x1 = x;
+			y1 = y;
+		}
+	}
+	if (x0 < 0. && x1 < 0.) {
+		addClippedEdge(0., y0, 0., y1);
+	} else if (x0 < 0. || x1 < 0.) {
+		auto x = 0., y = 0.;
+		split(0., x, y);
+		if (x0 < 0.) {
+			addClippedEdge(0., y0, 0., y);
+			addClippedEdge(x, y, x1, y1);
+		} else {
+			addClippedEdge(x0, y0, x, y);
+			addClippedEdge(0., y, 0., y1);
+		}
+	} else {
+		addClippedEdge(x0, y0, x1, y1);
+	}
+}
+
+void ScanlineRasterizer::addClippedEdge(
+		double x0,
+		double y0,
+		double x1,
+		double y1) {
+	if (y0 == y1) {
+		return;
+	}
+	auto edge = Edge();
+	if (y0 < y1) {
+		edge.direction = 1.f;
+	} else {
+		std::swap(x0, x1);
+		std::swap(y0, y1);
+		edge.direction = -1.f;
+	}
+	edge.topRow = int(std::max(std::floor(y0), 0.));
+	edge.bottomRow = int(std::min(std::ceil(y1), double(_height)));
+	if (edge.topRow >= edge.bottomRow) {
+		return;
+	}
+	edge.x0 = x0;
+	edge.y0 = y0;
+	edge.x1 = x1;
+	edge.y1 = y1;
+	edge.dxdy = (x1 - x0) / (y1 - y0);
+	_edges.push_back(edge);
+}
+
+void ScanlineRasterizer::accumulate(
+		const Edge &edge,
+		int row,
+		float *cells) const {
+	const auto ya = std::max(double(row), edge.y0);
+	const auto yb = std::min(double(row + 1), edge.y1);
+	if (yb <= ya) {
+		return;
+	}
+	const auto xa = (ya == edge.y0)
+		? edge.x0
+		: std::clamp(
+			edge.x0 + (ya - edge.y0) * edge.dxdy,
+			std::min(edge.x0, edge.x1),
+			std::max(edge.x0, edge.x1));
+	const auto xb = (yb == edge.y1)
+		? edge.x1
+		: std::clamp(
+			edge.x0 + (yb - edge.y0) * edge.dxdy,
+			std::min(edge.x0, edge.x1),
+			std::max(edge.x0, edge.x1));
+	const auto d = float(yb - ya) * edge.direction;
+	const auto x0 = float(std::min(xa, xb));
+	const auto x1 = float(std::max(xa, xb));
+	const auto x0floor = std::floor(x0);
+	const auto x0i = int(x0floor);
+	const auto x1ceil = std::ceil(x1);
+	const auto x1i = int(x1ceil);
+	if (x1i <= x0i + 1) {
+		// The edge stays inside one cell: split the area at its middle.
+		const auto xmf = 0.5f * (x0 + x1) - x0floor;
+		cells[x0i] += d - d * xmf;
+		cells[x0i + 1] += d * xmf;
+	} else {
+		// The covered area grows quadratically in the first and the last
+		// cells and linearly in the cells between them.
+		const auto s = 1.f / (x1 - x0);
+		const auto x0f = x0 - x0floor;
+		const auto a0 = 0.5f * s * (1.f - x0f) * (1.f - x0f);
+		const auto x1f = x1 - x1ceil + 1.f;
+		const auto am = 0.5f * s * x1f * x1f;
+		cells[x0i] += d * a0;
+		if (x1i == x0i + 2) {
+			cells[x0i + 1] += d * (1.f - a0 - am);
+		} else {
+			const auto a1 = s * (1.5f - x0f);
+			cells[x0i + 1] += d * (a1 - a0);
+			for (auto xi = x0i + 2; xi < x1i - 1; ++xi) {
+				cells[xi] += d * s;
+			}
+			const auto a2 = a1 + float(x1i - x0i - 3) * s;
+			cells[x1i - 1] += d * (1.f - a2 - am);
+		}
+		cells[x1i] += d * am;
+	}
+}
+
+void ScanlineRasterizer::render(
+		FillRule rule,
+		int fromRow,
+		int tillRow,
+		const SpanCallback &callback) const {
+	assert(_finished);
+
+	fromRow = std::max(fromRow, _top);
+	tillRow = std::min(tillRow, _bottom);
+	if (fromRow >= tillRow || !_width) {
+		return;
+	}
+
+	auto &buffers = ThreadBuffers();
+	auto &cells = buffers.cells;
+	auto &coverage = buffers.coverage;
+	auto &active = buffers.active;
+	cells.assign(_width + 2, 0.f);
+	coverage.resize(_width);
+	active.clear();
+	auto next = begin(_edges);
+	for (auto row = fromRow; row < tillRow; ++row) {
+		active.erase(std::remove_if(begin(active), end(active), [&](
+				const Edge *edge) {
+			return edge->bottomRow <= row;
+		}), end(active));
+		for (; next != end(_edges) && next->topRow <= row; ++next) {
+			if (next->bottomRow > row) {
+				active.push_back(&*next);
+			}
+		}
+		if (active.empty()) {
+			if (next == end(_edges)) {
+				break;
+			}
+			row = std::max(row, next->topRow - 1);
+			continue;
+		}
+
+		auto left = _width;
+		auto right = 0;
+		for (const auto edge : active) {
+			accumulate(*edge, row, cells.data());
+			left = std::min(
+				left,
+				int(std::floor(std::min(edge->x0, edge->x1))));
+			right = std::max(
+				right,
+				int(std::ceil(std::max(edge->x0, edge->x1))) + 2);
+		}
+		left = std::clamp(left, 0, _width);
+		right = std::clamp(right, left, _width + 2);
+
+		auto accumulated = 0.f;
+		const auto coverageAt = [&](float value) {
+			auto area = std::abs(value);
+			if (rule == FillRule::EvenOdd) {
+				area = std::fmod(area, 2.f);
+				if (area > 1.f) {
+					area = 2.f - area;
+				}
+			} else if (area > 1.f) {
+				area = 1.f;
+			}
+			return uint8_t(area * 255.f + 0.5f);
+		};
+		const auto visible = std::min(right, _width);
+		for (auto x = left; x != visible; ++x) {
+			accumulated += cells[x];
+			coverage[x] = coverageAt(accumulated);
+		}
+		for (auto x = left; x != right; ++x) {
+			cells[x] = 0.f;
+		}
+		auto till = visible;
+		const auto tail = coverageAt(accumulated);
+		if (tail) {
+			std::fill(
+				coverage.data() + visible,
+				coverage.data() + _width,
+				tail);
+			till = _width;
+		}
+		auto from = left;
+		while (from < till && !coverage[from]) {
+			++from;
+		}
+		while (till > from && !coverage[till - 1]) {
+			--till;
+		}
+		if (from < till) {
+			callback(row, from, till - from, coverage.data() + from);
+		}
+	}
+}
+
+} // namespace Lottie
@@ -0,0 +1,116 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace Lottie {
+
+// 64 bit FNV-1a, used to compare the drawing of consecutive frames.
+[[nodiscard]] uint64_t HashBytes(
+	uint64_t seed,
+	const void *data,
+	std::size_t size);
+
+// Analytic coverage rasterizer: edges accumulate signed area into a cell
+// row, a prefix sum over the row gives the exact coverage of each pixel.
+//
+// Every row is computed only from the original edge parameters and the
+// edges are always visited in the same order, so any range of rows gives
+// bit-identical results no matter which rows were rendered before.
+class ScanlineRasterizer final {
+public:
+	enum class FillRule {
+		NonZero,
+		EvenOdd,
+	};
+
+	using SpanCallback = std::function<void(
+		int y,
+		int x,
+		int count,
+		const uint8_t *coverage)>;
+
+	// Starts a new path, edges are clipped to [0, width) x [0, height).
+	void reset(int width, int height);
+
+	void moveTo(double x, double y);
+	void lineTo(double x, double y);
+	void cubicTo(
+		double x1,
+		double y1,
+		double x2,
+		double y2,
+		double x3,
+		double y3);
+	void close();
+
+	// Closes the path and prepares the edges for rendering. After that
+	// render() may be called from several threads at once.
+	void finish();
+
+	[[nodiscard]] bool empty() const;
+	[[nodiscard]] int top() const;
+	[[nodiscard]] int bottom() const;
+
+	// Columns [left, right) that can get any coverage.
+	[[nodiscard]] int left() const;
+	[[nodiscard]] int right() const;
+
+	// Hash of the finished edge list.
+	[[nodiscard]] uint64_t hash() const;
+
+	// Calls back for each row in [fromRow, tillRow) that has coverage.
+	// The callback must not render with another rasterizer.
+	void render(
+		FillRule rule,
+		int fromRow,
+		int tillRow,
+		const SpanCallback &callback) const;
+
+private:
+	struct Edge {
+		double x0 = 0.;
+		double y0 = 0.;
+		double x1 = 0.;
+		double y1 = 0.;
+		double dxdy = 0.;
+		float direction = 0.f;
+		int topRow = 0;
+		int bottomRow = 0;
+	};
+
+	struct Buffers;
+
+	[[nodiscard]] static Buffers &ThreadBuffers();
+
+	void addEdge(double x0, double y0, double x1, double y1);
+	void addClippedEdge(double x0, double y0, double x1, double y1);
+	void accumulate(const Edge &edge, int row, float *cells) const;
+
+	int _width = 0;
+	int _height = 0;
+	double _startX = 0.;
+	double _startY = 0.;
+	double _lastX = 0.;
+	double _lastY = 0.;
+	int _top = 0;
+	int _bottom = 0;
+	int _left = 0;
+	int _right = 0;
+	uint64_t _hash = 0;
+	bool _clippedRight = false;
+	bool _hasSubpath = false;
+	bool _finished = true;
+	std::vector<Edge> _edges;
+
+};
+
+} // namespace Lottie
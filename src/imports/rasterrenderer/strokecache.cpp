@@ -0,0 +1,123 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "strokecache.h"
+
+#include "scanlinerasterizer.h"
+
+#include <QPen>
+#include <QPainterPathStroker>
+
+namespace Lottie {
+namespace {
+
+[[nodiscard]] uint64_t HashPath(const QPainterPath &path) {
+	const auto rule = path.fillRule();
+	auto result = HashBytes(0, &rule, sizeof(rule));
+	for (auto i = 0, count = path.elementCount(); i != count; ++i) {
+		const auto &element = path.elementAt(i);
+		const double values[] = { element.x, element.y, double(element.type) };
+		result = HashBytes(result, values, sizeof(values));
+	}
+	return result;
+}
+
+// QPainterPath::operator==() compares the coordinates fuzzily.
+[[nodiscard]] bool SamePath(const QPainterPath &a, const QPainterPath &b) {
+	const auto count = a.elementCount();
+	if (b.elementCount() != count || a.fillRule() != b.fillRule()) {
+		return false;
+	}
+	for (auto i = 0; i != count; ++i) {
+		const auto &first = a.elementAt(i);
+		const auto &second = b.elementAt(i);
+		if (first.type != second.type
+			|| first.x != second.x
+			|| first.y != second.y) {
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace
+
+StrokeCache::StrokeCache(int limit)
+: _limit(std::max(limit, 2)) {
+}
+
+QPainterPath StrokeCache::outline(
+		const QPainterPath &path,
+		const QPen &pen) {
+	auto stroke = Stroke{
+		pen.widthF(),
+		int(pen.style()),
+		int(pen.capStyle()),
+		int(pen.joinStyle()),
+		pen.miterLimit(),
+		pen.dashOffset(),
+	};
+	if (pen.style() != Qt::SolidLine) {
+		stroke.dashes = pen.dashPattern();
+	}
+	const double values[] = {
+		stroke.width,
+		double(stroke.style),
+		double(stroke.cap),
+		double(stroke.join),
+		stroke.miterLimit,
+		stroke.dashOffset,
+	};
+	auto hash = HashBytes(HashPath(path), values, sizeof(values));
+	hash = HashBytes(
+		hash,
+		stroke.dashes.constData(),
+		stroke.dashes.size() * sizeof(qreal));
+
+	QMutexLocker lock(&_mutex);
+	++_counter;
+	const auto range = _entries.equal_range(hash);
+	for (auto i = range.first; i != range.second; ++i) {
+		auto &entry = i->second;
+		if (entry.stroke == stroke && SamePath(entry.path, path)) {
+			entry.lastUsed = _counter;
+			return entry.outline;
+		}
+	}
+	lock.unlock();
+
+	auto result = QPainterPathStroker(pen).createStroke(path);
+
+	lock.relock();
+	if (int(_entries.size()) >= _limit) {
+		collect();
+	}
+	_entries.emplace(hash, Entry{ path, std::move(stroke), result, _counter });
+	return result;
+}
+
+void StrokeCache::clear() {
+	QMutexLocker lock(&_mutex);
+	_entries.clear();
+}
+
+// Each lookup uses one entry, so at least half of them were not used
+// in the last limit / 2 lookups and are removed.
+void StrokeCache::collect() {
+	const auto threshold = (_counter > uint64_t(_limit / 2))
+		? (_counter - _limit / 2)
+		: 0;
+	for (auto i = _entries.begin(); i != _entries.end();) {
+		if (i->second.lastUsed <= threshold) {
+			i = _entries.erase(i);
+		} else {
+			++i;
+		}
+	}
+}
+
+} // namespace Lottie
@@ -0,0 +1,71 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include <QPainterPath>
+#include <QVector>
+#include <QMutex>
+
+#include <unordered_map>
+
+class QPen;
+
+namespace Lottie {
+
+// Outlines of the strokes drawn in the previous frames, kept so that
+// strokes of static or held shapes are converted to fills only once.
+// May be shared between canvases on different threads.
+class StrokeCache final {
+public:
+	explicit StrokeCache(int limit = 1024);
+
+	// The outline to fill instead of stroking the path with the pen.
+	// The pen must not be cosmetic, those are stroked in device space.
+	[[nodiscard]] QPainterPath outline(
+		const QPainterPath &path,
+		const QPen &pen);
+
+	void clear();
+
+private:
+	struct Stroke {
+		qreal width = 0.;
+		int style = 0;
+		int cap = 0;
+		int join = 0;
+		qreal miterLimit = 0.;
+		qreal dashOffset = 0.;
+		QVector<qreal> dashes;
+
+		friend inline bool operator==(const Stroke &a, const Stroke &b) {
+			return (a.width == b.width)
+				&& (a.style == b.style)
+				&& (a.cap == b.cap)
+				&& (a.join == b.join)
+				&& (a.miterLimit == b.miterLimit)
+				&& (a.dashOffset == b.dashOffset)
+				&& (a.dashes == b.dashes);
+		}
+	};
+	struct Entry {
+		QPainterPath path;
+		Stroke stroke;
+		QPainterPath outline;
+		uint64_t lastUsed = 0;
+	};
+
+	void collect();
+
+	const int _limit = 0;
+	QMutex _mutex;
+	std::unordered_multimap<uint64_t, Entry> _entries;
+	uint64_t _counter = 0;
+
+};
+
+} // namespace Lottie